@@ -119,6 +119,24 @@ int main() {
         else if (!PolyStackAt(&poly_stack, strtoll(line + 3, NULL, 10)))
           safePrintError(current_line, "STACK UNDERFLOW");
       }
+      else if (!strcmp(line, "COMPILE")) {
+        if (!PolyStackCompile(&poly_stack))
+          safePrintError(current_line, "STACK UNDERFLOW");
+      }
+      else if (!strncmp("EVAL", line, 4)) {
+        // Liczba wartości zależy od długości wiersza, więc tablica nie może
+        // leżeć na stosie.
+        poly_coeff_t *x = (poly_coeff_t *)safeMalloc(
+          (strlen(line) / 2 + 1) * sizeof(poly_coeff_t));
+        size_t k;
+        if (strlen(line) > 4 && !isspace(line[4]))
+          safePrintError(current_line, "WRONG COMMAND");
+        else if (!readLLs(line + 4, x, &k))
+          safePrintError(current_line, "EVAL WRONG VALUE");
+        else if (!PolyStackEval(&poly_stack, k, x))
+          safePrintError(current_line, "STACK UNDERFLOW");
+        free(x);
+      }
       else if (!strcmp(line, "PRINT")) {
         if (!PolyStackPrint(&poly_stack))
           safePrintError(current_line, "STACK UNDERFLOW");
@@ -127,6 +145,27 @@ int main() {
         if (!PolyStackPop(&poly_stack))
           safePrintError(current_line, "STACK UNDERFLOW");
       }
+      else if (!strncmp("COMPOSE_BATCH", line, 13)) {
+        if (strlen(line) == 13) {
+          safePrintError(current_line, "COMPOSE_BATCH WRONG PARAMETER");
+        }
+        else if (!isspace(line[13])) {
+          safePrintError(current_line, "WRONG COMMAND");
+        }
+        else if (line[13] != ' ' || !isULLPair(line + 14)) {
+          safePrintError(current_line, "COMPOSE_BATCH WRONG PARAMETER");
+        }
+        else {
+          char *second;
+          unsigned long long n = strtoull(line + 14, &second, 10);
+          unsigned long long k = strtoull(second + 1, NULL, 10);
+          // Złożenie zera wielomianów zdjęłoby ze stosu same wielomiany q.
+          if (n == 0)
+            safePrintError(current_line, "COMPOSE_BATCH WRONG PARAMETER");
+          else if (!PolyStackComposeBatch(&poly_stack, n, k))
+            safePrintError(current_line, "STACK UNDERFLOW");
+        }
+      }
       else if (!strncmp("COMPOSE", line, 7)) {
         if (strlen(line) == 7)
           safePrintError(current_line, "COMPOSE WRONG PARAMETER");
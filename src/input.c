@@ -42,6 +42,40 @@ bool isULL(const char *str) {
   return *end_ptr == '\0' && errno == 0;
 }
 
+bool isULLPair(const char *str) {
+  const char *space = strchr(str, ' ');
+  if (space == NULL)
+    return false;
+
+  char first[space - str + 1];
+  memcpy(first, str, space - str);
+  first[space - str] = '\0';
+
+  return isULL(first) && isULL(space + 1);
+}
+
+bool readLLs(const char *str, poly_coeff_t values[], size_t *count) {
+  *count = 0;
+  while (*str != '\0') {
+    if (*str != ' ')
+      return false;
+    str++;
+
+    const char *end = strchr(str, ' ');
+    if (end == NULL)
+      end = str + strlen(str);
+    char word[end - str + 1];
+    memcpy(word, str, end - str);
+    word[end - str] = '\0';
+    if (!isLL(word))
+      return false;
+
+    values[(*count)++] = strtoll(word, NULL, 10);
+    str = end;
+  }
+  return true;
+}
+
 bool isLL(const char *str) {
   if (strlen(str) == 0 || (!isDigit(str[0]) && str[0] != '-'))
     return false;
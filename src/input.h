@@ -26,6 +26,14 @@ bool isLetter(char ch);
  */
 bool isULL(const char *str);
 
+/**
+ * Sprawdza, czy słowo składa się z dwóch liczb z zakresu unsigned long long
+ * oddzielonych pojedynczą spacją.
+ * @param[in] str : słowo
+ * @return czy słowo jest parą unsigned long longów?
+ */
+bool isULLPair(const char *str);
+
 /**
  * Sprawdza, czy słowo jest liczbą z zakeresu long long.
  * @param[in] str : słowo
@@ -33,6 +41,16 @@ bool isULL(const char *str);
  */
 bool isLL(const char *str);
 
+/**
+ * Wczytuje ciąg liczb z zakresu long long, z których każda jest poprzedzona
+ * pojedynczą spacją. Tablica @p values musi pomieścić @f$|str| / 2@f$ liczb.
+ * @param[in] str : słowo
+ * @param[out] values : tablica na wczytane liczby
+ * @param[out] count : liczba wczytanych liczb
+ * @return czy słowo jest poprawnym ciągiem liczb?
+ */
+bool readLLs(const char *str, poly_coeff_t values[], size_t *count);
+
 /**
  * Wczytuje wielomian. Informuje, jeśli wczytywany wielomian jest błędny,
  * ustawiając *wrong_poly na true.
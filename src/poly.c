@@ -6,8 +6,20 @@
 */
 
 #include "poly.h"
+#include "poly_alloc.h"
+#include "poly_intern.h"
+#include "poly_mul.h"
 #include "safe_functions.h"
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef POLY_HUGE_PAGES
+/** Duże obszary operacji korzystają z przezroczystych dużych stron. */
+#define ARENA_HUGE_PAGES true
+#else
+/** Obszary operacji korzystają ze zwykłych stron. */
+#define ARENA_HUGE_PAGES false
+#endif
 
 /**
  * Komparator porównujący jednomiany po wykładniku wykorzystywany przez qsort.
@@ -39,19 +51,6 @@ static Poly PolySortByExp(const Poly *p) {
   return *p;
 }
 
-/**
- * Dodaje dwa wielomiany i usuwa je z pamięci.
- * @param[in] p : wielomian @f$p@f$
- * @param[in] q : wielomian @f$q@f$
- * @return @f$p + q@f$
- */
-static Poly PolyAddAndClean(Poly *p, Poly *q) {
-  Poly sum = PolyAdd(p, q);
-  PolyDestroy(p);
-  PolyDestroy(q);
-  return sum;
-}
-
 /**
  * Łączy sąsiednie jednomiany o równym wykładniku w wielomianie.
  * Zwracany wielomian jest tożsamościowo równy @p p.
@@ -64,7 +63,7 @@ static Poly PolyMergeMonosWithEqualExp(Poly *p) {
     int actual = 0;
     for (size_t i = 1; i < p->size; i++) {
       if (p->arr[i].exp == p->arr[actual].exp) {
-        p->arr[actual].p = PolyAddAndClean(&(p->arr[actual].p), &(p->arr[i].p));
+        p->arr[actual].p = PolyAddOwn(&(p->arr[actual].p), &(p->arr[i].p));
       }
       else {
         actual++;
@@ -111,28 +110,6 @@ static Poly PolyDeleteZeros(Poly *p) {
   return *p;
 }
 
-/**
- * Sprowadza wielomian @f$Cx_i^0@f$ do współczynnika @f$C@f$.
- * Jeśli wielomian jest innej postaci, nie rusza go.
- * Po wywołaniu tej funcji wielomian będący współczynnikiem jest reprezentowany
- * jednoznacznie.
- * Zwracany wielomian jest tożsamościowo równy @p p.
- * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
- * @param[in] p : wielomian
- * @return wielomian, być może poprawiony, jeśli jest współczynnikiem
- */
-static Poly PolyCorrectIfCoeff(const Poly *p) {
-  if (!PolyIsCoeff(p) && p->size == 1 && p->arr[0].exp == 0 &&
-      PolyIsCoeff(&(p->arr[0].p))) {
-    Poly p_correct = PolyClone(&(p->arr[0].p));
-    PolyDestroy((Poly *) p);
-    return p_correct;
-  }
-  else {
-    return *p;
-  }
-}
-
 /**
  * Sprowadza wielomian do jednoznaczej, uporządkowanej postaci.
  * Tożsamościowo równe wielomiany sprowadzone do jednoznacznej postaci są
@@ -142,6 +119,7 @@ static Poly PolyCorrectIfCoeff(const Poly *p) {
  * - złączenie (dodanie) wszystkich jednomianów o równych wykładnikach
  * - brak jednomianów zerowych
  * - jednoznaczne reprezentowanie wielomianu będącego współczynnikiem
+ * - przechowywanie jednomianu @f$cx_i^e@f$ bez tablicy jednomianów
  *
  * Zwracany wielomian jest tożsamościowo równy @p p.
  * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
@@ -152,67 +130,203 @@ static Poly PolyCorrect(const Poly *p) {
   Poly p_sorted = PolySortByExp(p);
   Poly p_merged = PolyMergeMonosWithEqualExp(&p_sorted);
   Poly p_without_zeros = PolyDeleteZeros(&p_merged);
-  Poly p_correct = PolyCorrectIfCoeff(&p_without_zeros);
-  return p_correct;
+  if (PolyIsCoeff(&p_without_zeros))
+    return p_without_zeros;
+  return PolyFromMonos(p_without_zeros.size, p_without_zeros.arr);
 }
 
 void PolyDestroy(Poly *p) {
-  if (!PolyIsCoeff(p)) {
+  // Współdzielona tablica jest usuwana dopiero z ostatnim odwołaniem.
+  if (!PolyIsCoeff(p) && !PolyIsInline(p) && PolyInternRelease(p)) {
     for (size_t i = 0; i < p->size; i++)
       MonoDestroy(&(p->arr[i]));
-    free(p->arr);
+    PolyMonosFree(p->arr);
   }
 }
 
 Poly PolyClone(const Poly *p) {
-  Poly clone;
+  if (PolyIsCoeff(p) || PolyIsInline(p))
+    return *p;
 
-  if (PolyIsCoeff(p)) {
-    clone = PolyFromCoeff(p->coeff);
+  PolyMonosRetain(p->arr);
+  return *p;
+}
+
+/**
+ * Sprawdza, czy wielomian współdzieli tablicę jednomianów z innym
+ * wielomianem albo nie ma tablicy, a więc nie może być modyfikowany w miejscu.
+ * @param[in] p : wielomian
+ * @return czy jednomianów @p p nie można modyfikować w miejscu?
+ */
+static inline bool PolyIsShared(const Poly *p) {
+  return !PolyIsCoeff(p) && (PolyIsInline(p) || PolyMonosIsShared(p->arr));
+}
+
+/**
+ * Przenosi jednomiany wielomianu niebędącego współczynnikiem do tablicy
+ * @p dst. Jednomiany współdzielonej tablicy są kopiowane, a jednomian
+ * wielomianu bez tablicy jest zapisywany w @p dst.
+ * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
+ * @param[in] p : wielomian
+ * @param[in] dst : tablica mieszcząca jednomiany @p p
+ * @return liczba przeniesionych jednomianów
+ */
+static size_t PolyMoveMonos(Poly *p, Mono *dst) {
+  assert(!PolyIsCoeff(p));
+  size_t size = PolySize(p);
+  if (PolyIsShared(p)) {
+    Mono buffer;
+    const Mono *arr = PolyMonos(p, &buffer);
+    for (size_t i = 0; i < size; i++)
+      dst[i] = MonoClone(&(arr[i]));
+    PolyDestroy(p);
   }
   else {
-    clone.size = p->size;
-    clone.arr = (Mono *)safeMalloc(clone.size * sizeof(Mono));
-    for (size_t i = 0; i < clone.size; i++)
-      clone.arr[i] = MonoClone(&(p->arr[i]));
+    memcpy(dst, p->arr, size * sizeof(Mono));
+    PolyMonosFree(p->arr);
   }
-
-  return clone;
+  return size;
 }
 
-Poly PolyAdd(const Poly *p, const Poly *q) {
-  Poly sum;
+/**
+ * Tworzy wielomian z tablicy jednomianów posortowanych ściśle rosnąco po
+ * wykładnikach i mających niezerowe współczynniki. Tablica ma pojemność
+ * @p capacity, a wypełnionych jest jej pierwszych @p count elementów.
+ * Przejmuje na własność tablicę @p arr i jej zawartość.
+ * @param[in] count : liczba jednomianów
+ * @param[in] capacity : rozmiar tablicy @p arr
+ * @param[in] arr : tablica jednomianów
+ * @return wielomian w jednoznacznej, uporządkowanej postaci
+ */
+static Poly PolyFromSortedMonos(size_t count, size_t capacity, Mono *arr) {
+  if (count == 0) {
+    PolyMonosFree(arr);
+    return PolyZero();
+  }
+  else {
+    if (count < capacity && (count > 1 || !PolyIsCoeff(&(arr[0].p))))
+      arr = PolyMonosRealloc(arr, count);
+    return PolyFromMonos(count, arr);
+  }
+}
 
-  if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-    sum = PolyFromCoeff(p->coeff + q->coeff);
+/**
+ * Udostępnia jednomiany wielomianu w postaci tablicy. Wielomian niezerowy
+ * będący współczynnikiem @f$C@f$ jest traktowany jak jednomian @f$Cx_i^0@f$,
+ * który, podobnie jak jednomian wielomianu bez tablicy, jest zapisywany
+ * w @p buffer. Wielomian zerowy nie ma jednomianów.
+ * @param[in] p : wielomian
+ * @param[in] buffer : miejsce na jednomian
+ * @param[out] arr : tablica jednomianów wielomianu
+ * @return liczba jednomianów
+ */
+static size_t PolyMonosView(const Poly *p, Mono *buffer, const Mono **arr) {
+  if (!PolyIsCoeff(p)) {
+    *arr = PolyMonos(p, buffer);
+    return PolySize(p);
   }
   else {
-    sum.size = (PolyIsCoeff(p) ? 1 : p->size) + (PolyIsCoeff(q) ? 1 : q->size);
-    sum.arr = (Mono *)safeMalloc(sum.size * sizeof(Mono));
+    *buffer = (Mono) {.p = *p, .exp = 0};
+    *arr = buffer;
+    return PolyIsZero(p) ? 0 : 1;
+  }
+}
 
-    if (PolyIsCoeff(p)) {
-      Poly p_clone = PolyClone(p);
-      sum.arr[0] = MonoFromPoly(&p_clone, 0);
+Poly PolyAdd(const Poly *p, const Poly *q) {
+  if (PolyIsCoeff(p) && PolyIsCoeff(q))
+    return PolyFromCoeff(p->coeff + q->coeff);
+  else if (PolyIsZero(p))
+    return PolyClone(q);
+  else if (PolyIsZero(q))
+    return PolyClone(p);
+
+  Mono p_buffer, q_buffer;
+  const Mono *p_arr, *q_arr;
+  size_t p_size = PolyMonosView(p, &p_buffer, &p_arr);
+  size_t q_size = PolyMonosView(q, &q_buffer, &q_arr);
+
+  // Scalanie dwóch posortowanych list jednomianów. Rekurencja zachodzi tylko
+  // dla jednomianów o równych wykładnikach.
+  size_t capacity = p_size + q_size;
+  Mono *arr = PolyMonosAlloc(capacity);
+  size_t count = 0, i = 0, j = 0;
+  while (i < p_size || j < q_size) {
+    if (j == q_size || (i < p_size && p_arr[i].exp < q_arr[j].exp)) {
+      arr[count++] = MonoClone(&(p_arr[i++]));
+    }
+    else if (i == p_size || q_arr[j].exp < p_arr[i].exp) {
+      arr[count++] = MonoClone(&(q_arr[j++]));
     }
     else {
-      for (size_t i = 0; i < p->size; i++)
-        sum.arr[i] = MonoClone(&(p->arr[i]));
+      Poly sum = PolyAdd(&(p_arr[i].p), &(q_arr[j].p));
+      if (!PolyIsZero(&sum))
+        arr[count++] = MonoFromPoly(&sum, p_arr[i].exp);
+      i++;
+      j++;
     }
+  }
 
-    if (PolyIsCoeff(q)) {
-      Poly q_clone = PolyClone(q);
-      sum.arr[sum.size - 1] = MonoFromPoly(&q_clone, 0);
+  return PolyFromSortedMonos(count, capacity, arr);
+}
+
+Poly PolyAddOwn(Poly *p, Poly *q) {
+  assert(p != q);
+  if (PolyIsCoeff(p) && PolyIsCoeff(q))
+    return PolyFromCoeff(p->coeff + q->coeff);
+  else if (PolyIsZero(p))
+    return *q;
+  else if (PolyIsZero(q))
+    return *p;
+
+  // Współdzielonych tablic nie można modyfikować, więc wynik powstaje tak jak
+  // w PolyAdd, współdzieląc niezmienione poziomy.
+  if (PolyIsShared(p) || PolyIsShared(q)) {
+    Poly sum = PolyAdd(p, q);
+    PolyDestroy(p);
+    PolyDestroy(q);
+    return sum;
+  }
+
+  // Wynik budujemy w dłuższej z tablic jednomianów (dst), do której scalamy
+  // jednomiany drugiego wielomianu (src). Jednomiany dst przesuwamy na koniec
+  // powiększonej tablicy, więc scalanie od początku nigdy nie nadpisuje
+  // jednomianów, które nie zostały jeszcze odczytane.
+  if (PolyIsCoeff(p) || (!PolyIsCoeff(q) && q->size > p->size)) {
+    Poly *tmp = p;
+    p = q;
+    q = tmp;
+  }
+  Mono q_buffer;
+  const Mono *src;
+  size_t dst_size = p->size;
+  size_t src_size = PolyMonosView(q, &q_buffer, &src);
+  size_t capacity = dst_size + src_size;
+  Mono *arr = PolyMonosRealloc(p->arr, capacity);
+  memmove(arr + src_size, arr, dst_size * sizeof(Mono));
+  const Mono *dst = arr + src_size;
+
+  size_t count = 0, i = 0, j = 0;
+  while (i < dst_size || j < src_size) {
+    if (j == src_size || (i < dst_size && dst[i].exp < src[j].exp)) {
+      arr[count++] = dst[i++];
+    }
+    else if (i == dst_size || src[j].exp < dst[i].exp) {
+      arr[count++] = src[j++];
     }
     else {
-      for (size_t i = 0; i < q->size; i++)
-        sum.arr[i + sum.size - q->size] = MonoClone(&(q->arr[i]));
+      Poly dst_p = dst[i].p, src_p = src[j].p;
+      poly_exp_t exp = dst[i].exp;
+      Poly sum = PolyAddOwn(&dst_p, &src_p);
+      if (!PolyIsZero(&sum))
+        arr[count++] = MonoFromPoly(&sum, exp);
+      i++;
+      j++;
     }
-
-    // uporządkowanie zwracanego wielomianu
-    sum = PolyCorrect(&sum);
   }
 
-  return sum;
+  if (!PolyIsCoeff(q))
+    PolyMonosFree(q->arr);
+  return PolyFromSortedMonos(count, capacity, arr);
 }
 
 Poly PolyAddMonos(size_t count, const Mono monos[]) {
@@ -221,9 +335,16 @@ Poly PolyAddMonos(size_t count, const Mono monos[]) {
   if (count == 0 || monos == NULL) {
     p = PolyZero();
   }
+  else if (count == 1 && PolyIsCoeff(&(monos[0].p))) {
+    // Jednomian o stałym współczynniku nie potrzebuje tablicy.
+    if (PolyIsZero(&(monos[0].p)) || monos[0].exp == 0)
+      p = monos[0].p;
+    else
+      p = PolyInline(monos[0].p.coeff, monos[0].exp);
+  }
   else {
     p.size = count;
-    p.arr = (Mono *)safeMalloc(p.size * sizeof(Mono));
+    p.arr = PolyMonosAlloc(p.size);
     for (size_t i = 0; i < count; i++)
       p.arr[i] = monos[i];
 
@@ -247,57 +368,285 @@ Poly PolyCloneMonos(size_t count, const Mono monos[]) {
   return PolyOwnMonos(count, monos_clone);
 }
 
-Poly PolyMul(const Poly *p, const Poly *q) {
-  Poly prod;
+/**
+ * Mnoży wielomian przez niezerowy współczynnik.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] c : współczynnik @f$c@f$
+ * @return @f$p * c@f$
+ */
+static Poly PolyMulByCoeff(const Poly *p, const Poly *c) {
+  assert(!PolyIsCoeff(p) && PolyIsCoeff(c));
+  if (c->coeff == 1)
+    return PolyClone(p);
+  if (PolyIsInline(p)) {
+    poly_coeff_t prod = p->coeff * c->coeff;
+    return prod == 0 ? PolyZero() : PolyInline(prod, PolyInlineExp(p));
+  }
 
-  if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-    prod.coeff = p->coeff * q->coeff;
-    prod.arr = NULL;
+  Mono *arr = PolyMonosAlloc(p->size);
+  size_t count = 0;
+  // Mnożenie nie zmienia wykładników, więc kolejność jednomianów jest
+  // zachowana. Znikać mogą jedynie jednomiany, których współczynnik się
+  // przepełnił.
+  for (size_t i = 0; i < p->size; i++) {
+    Poly prod = PolyMul(&(p->arr[i].p), c);
+    if (!PolyIsZero(&prod))
+      arr[count++] = MonoFromPoly(&prod, p->arr[i].exp);
   }
-  else {
-    prod.size = (PolyIsCoeff(p) ? 1 : p->size) * (PolyIsCoeff(q) ? 1 : q->size);
-    prod.arr = (Mono *)safeMalloc(prod.size * sizeof(Mono));
+  return PolyFromSortedMonos(count, p->size, arr);
+}
+
+/**
+ * To jest struktura przechowująca element kopca wykorzystywanego przy mnożeniu
+ * wielomianów. Element odpowiada iloczynowi jednomianu @p row pierwszego
+ * czynnika i jednomianu @p col drugiego czynnika.
+ */
+typedef struct MulHeapEntry {
+  poly_exp_t exp; ///< wykładnik iloczynu jednomianów
+  size_t row; ///< indeks jednomianu w pierwszym czynniku
+  size_t col; ///< indeks jednomianu w drugim czynniku
+} MulHeapEntry;
+
+/**
+ * Przywraca własność kopca typu min, przesuwając element @p i w dół.
+ * @param[in] heap : kopiec
+ * @param[in] size : liczba elementów kopca
+ * @param[in] i : indeks przesuwanego elementu
+ */
+static void MulHeapSiftDown(MulHeapEntry heap[], size_t size, size_t i) {
+  MulHeapEntry entry = heap[i];
+  while (2 * i + 1 < size) {
+    size_t child = 2 * i + 1;
+    if (child + 1 < size && heap[child + 1].exp < heap[child].exp)
+      child++;
+    if (heap[child].exp >= entry.exp)
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = entry;
+}
 
-    if (PolyIsCoeff(p)) {
-      for (size_t i = 0; i < prod.size; i++) {
-        prod.arr[i].exp = q->arr[i].exp;
-        prod.arr[i].p = PolyMul(p, &(q->arr[i].p));
+/**
+ * Mnoży dwa wielomiany niebędące współczynnikami, wyznaczając jednomiany
+ * iloczynu w kolejności rosnących wykładników. Kopiec zawiera po jednym
+ * kandydacie z każdego jednomianu krótszego czynnika, więc ma rozmiar
+ * @f$\min(n, m)@f$. Iloczyny o równych wykładnikach są sumowane od razu po
+ * zdjęciu z kopca, więc zużycie pamięci zależy od rozmiaru wyniku, a nie od
+ * liczby iloczynów częściowych.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+static Poly PolyMulHeap(const Poly *p, const Poly *q) {
+  assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+  if (PolySize(p) > PolySize(q)) {
+    const Poly *tmp = p;
+    p = q;
+    q = tmp;
+  }
+  Mono p_buffer, q_buffer;
+  const Mono *p_arr = PolyMonos(p, &p_buffer);
+  const Mono *q_arr = PolyMonos(q, &q_buffer);
+  size_t q_size = PolySize(q);
+
+  size_t heap_size = PolySize(p);
+  MulHeapEntry *heap =
+    (MulHeapEntry *)safeMalloc(heap_size * sizeof(MulHeapEntry));
+  for (size_t i = 0; i < heap_size; i++)
+    heap[i] = (MulHeapEntry) {.exp = p_arr[i].exp + q_arr[0].exp,
+                              .row = i, .col = 0};
+  // Wiersze są posortowane po wykładnikach, więc tablica jest już kopcem.
+
+  size_t capacity = q_size;
+  size_t count = 0;
+  Mono *arr = PolyMonosAlloc(capacity);
+  Poly acc = PolyZero(); // suma iloczynów o wykładniku acc_exp
+  poly_exp_t acc_exp = heap[0].exp;
+
+  while (heap_size > 0) {
+    MulHeapEntry top = heap[0];
+    if (top.exp != acc_exp) {
+      if (!PolyIsZero(&acc)) {
+        if (count == capacity) {
+          capacity *= 2;
+          arr = PolyMonosRealloc(arr, capacity);
+        }
+        arr[count++] = MonoFromPoly(&acc, acc_exp);
       }
+      acc = PolyZero();
+      acc_exp = top.exp;
     }
-    else if (PolyIsCoeff(q)) {
-      for (size_t i = 0; i < prod.size; i++) {
-        prod.arr[i].exp = p->arr[i].exp;
-        prod.arr[i].p = PolyMul(q, &(p->arr[i].p));
-      }
+
+    Poly prod = PolyMul(&(p_arr[top.row].p), &(q_arr[top.col].p));
+    acc = PolyAddOwn(&acc, &prod);
+
+    if (top.col + 1 < q_size) {
+      heap[0].col++;
+      heap[0].exp = p_arr[top.row].exp + q_arr[top.col + 1].exp;
     }
     else {
-      for (size_t i = 0; i < p->size; i++)
-        for (size_t j = 0; j < q->size; j++) {
-          int index = (int)(i * q->size + j);
-          prod.arr[index].exp = p->arr[i].exp + q->arr[j].exp;
-          prod.arr[index].p = PolyMul(&(p->arr[i].p), &(q->arr[j].p));
-        }
+      heap[0] = heap[--heap_size];
     }
+    MulHeapSiftDown(heap, heap_size, 0);
+  }
 
-    // uporządkowanie zwracanego wielomianu
-    prod = PolyCorrect(&prod);
+  if (!PolyIsZero(&acc)) {
+    if (count == capacity) {
+      capacity++;
+      arr = PolyMonosRealloc(arr, capacity);
+    }
+    arr[count++] = MonoFromPoly(&acc, acc_exp);
   }
 
-  return prod;
+  free(heap);
+  return PolyFromSortedMonos(count, capacity, arr);
+}
+
+Poly PolyMul(const Poly *p, const Poly *q) {
+  Poly prod;
+
+  if (PolyIsCoeff(p) && PolyIsCoeff(q))
+    return PolyFromCoeff(p->coeff * q->coeff);
+  else if (PolyIsZero(p) || PolyIsZero(q))
+    return PolyZero();
+  else if (PolyIsCoeff(p))
+    return PolyMulByCoeff(q, p);
+  else if (PolyIsCoeff(q))
+    return PolyMulByCoeff(p, q);
+  else if (PolyMulParallel(p, q, &prod))
+    return prod;
+  else if (PolyMulKronecker(p, q, &prod))
+    return prod;
+  else
+    return PolyMulHeap(p, q);
+}
+
+/**
+ * Mnoży wielomian przez niezerowy współczynnik w miejscu, przejmując
+ * wielomian na własność.
+ * @param[in] p : wielomian @f$p@f$ niebędący współczynnikiem
+ * @param[in] c : współczynnik @f$c@f$
+ * @return @f$p * c@f$
+ */
+static Poly PolyMulByCoeffOwn(Poly *p, const Poly *c) {
+  assert(!PolyIsCoeff(p) && PolyIsCoeff(c));
+  if (PolyIsShared(p)) {
+    Poly prod = PolyMulByCoeff(p, c);
+    PolyDestroy(p);
+    return prod;
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < p->size; i++) {
+    Poly prod;
+    if (PolyIsCoeff(&(p->arr[i].p)))
+      prod = PolyFromCoeff(p->arr[i].p.coeff * c->coeff);
+    else
+      prod = PolyMulByCoeffOwn(&(p->arr[i].p), c);
+    if (!PolyIsZero(&prod))
+      p->arr[count++] = MonoFromPoly(&prod, p->arr[i].exp);
+  }
+  return PolyFromSortedMonos(count, p->size, p->arr);
+}
+
+Poly PolyMulOwn(Poly *p, Poly *q) {
+  assert(p != q);
+  if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+    return PolyFromCoeff(p->coeff * q->coeff);
+  }
+  else if (PolyIsZero(p) || PolyIsZero(q)) {
+    PolyDestroy(p);
+    PolyDestroy(q);
+    return PolyZero();
+  }
+  else if (PolyIsCoeff(p)) {
+    return PolyMulByCoeffOwn(q, p);
+  }
+  else if (PolyIsCoeff(q)) {
+    return PolyMulByCoeffOwn(p, q);
+  }
+  else {
+    Poly prod = PolyMul(p, q);
+    PolyDestroy(p);
+    PolyDestroy(q);
+    return prod;
+  }
+}
+
+Poly PolyNegOwn(Poly *p) {
+  // Negacja nie zmienia wykładników ani nie zeruje współczynników, więc
+  // struktura wielomianu pozostaje jednoznaczna.
+  if (PolyIsCoeff(p) || PolyIsInline(p)) {
+    p->coeff = -p->coeff;
+  }
+  else if (PolyIsShared(p)) {
+    Poly neg = PolyNeg(p);
+    PolyDestroy(p);
+    return neg;
+  }
+  else {
+    for (size_t i = 0; i < p->size; i++)
+      p->arr[i].p = PolyNegOwn(&(p->arr[i].p));
+    return PolyIntern(p);
+  }
+  return *p;
+}
+
+Poly PolySubOwn(Poly *p, Poly *q) {
+  assert(p != q);
+  Poly neg_q = PolyNegOwn(q);
+  return PolyAddOwn(p, &neg_q);
 }
 
 Poly PolyNeg(const Poly *p) {
-  Poly minus_one = PolyFromCoeff(-1);
-  Poly result = PolyMul(p, &minus_one);
-  PolyDestroy(&minus_one);
-  return result;
+  // Negacja zachowuje kolejność i niezerowość jednomianów, więc wystarczy
+  // skopiować strukturę wielomianu, negując współczynniki.
+  if (PolyIsCoeff(p))
+    return PolyFromCoeff(-p->coeff);
+  else if (PolyIsInline(p))
+    return PolyInline(-p->coeff, PolyInlineExp(p));
+
+  Mono *arr = PolyMonosAlloc(p->size);
+  for (size_t i = 0; i < p->size; i++) {
+    arr[i].exp = p->arr[i].exp;
+    arr[i].p = PolyNeg(&(p->arr[i].p));
+  }
+  Poly neg = {.size = p->size, .arr = arr};
+  return PolyIntern(&neg);
 }
 
 Poly PolySub(const Poly *p, const Poly *q) {
-  Poly neg_q = PolyNeg(q);
-  Poly result = PolyAdd(p, &neg_q);
-  PolyDestroy(&neg_q);
-  return result;
+  if (PolyIsCoeff(p) && PolyIsCoeff(q))
+    return PolyFromCoeff(p->coeff - q->coeff);
+
+  Mono p_buffer, q_buffer;
+  const Mono *p_arr, *q_arr;
+  size_t p_size = PolyMonosView(p, &p_buffer, &p_arr);
+  size_t q_size = PolyMonosView(q, &q_buffer, &q_arr);
+
+  // Scalanie jak w PolyAdd, ale jednomiany q są negowane w locie.
+  size_t capacity = p_size + q_size;
+  Mono *arr = PolyMonosAlloc(capacity);
+  size_t count = 0, i = 0, j = 0;
+  while (i < p_size || j < q_size) {
+    if (j == q_size || (i < p_size && p_arr[i].exp < q_arr[j].exp)) {
+      arr[count++] = MonoClone(&(p_arr[i++]));
+    }
+    else if (i == p_size || q_arr[j].exp < p_arr[i].exp) {
+      Poly neg = PolyNeg(&(q_arr[j].p));
+      arr[count++] = MonoFromPoly(&neg, q_arr[j++].exp);
+    }
+    else {
+      Poly diff = PolySub(&(p_arr[i].p), &(q_arr[j].p));
+      if (!PolyIsZero(&diff))
+        arr[count++] = MonoFromPoly(&diff, p_arr[i].exp);
+      i++;
+      j++;
+    }
+  }
+
+  return PolyFromSortedMonos(count, capacity, arr);
 }
 
 poly_exp_t PolyDegBy(const Poly *p, unsigned long long var_idx) {
@@ -308,12 +657,14 @@ poly_exp_t PolyDegBy(const Poly *p, unsigned long long var_idx) {
     return 0;
   }
   else if (var_idx == 0) {
-    return p->arr[p->size - 1].exp;
+    return PolyIsInline(p) ? PolyInlineExp(p) : p->arr[p->size - 1].exp;
   }
   else {
+    Mono buffer;
+    const Mono *arr = PolyMonos(p, &buffer);
     poly_exp_t deg = -1;
-    for (size_t i = 0; i < p->size; i++) {
-      poly_exp_t deg_of_mono = PolyDegBy(&(p->arr[i].p), var_idx - 1);
+    for (size_t i = 0; i < PolySize(p); i++) {
+      poly_exp_t deg_of_mono = PolyDegBy(&(arr[i].p), var_idx - 1);
       if (deg_of_mono > deg)
         deg = deg_of_mono;
     }
@@ -329,9 +680,11 @@ poly_exp_t PolyDeg(const Poly *p) {
     return 0;
   }
   else {
+    Mono buffer;
+    const Mono *arr = PolyMonos(p, &buffer);
     poly_exp_t deg = -1;
-    for (size_t i = 0; i < p->size; i++) {
-      poly_exp_t deg_of_mono = PolyDeg(&(p->arr[i].p)) + p->arr[i].exp;
+    for (size_t i = 0; i < PolySize(p); i++) {
+      poly_exp_t deg_of_mono = PolyDeg(&(arr[i].p)) + arr[i].exp;
       if (deg_of_mono > deg)
         deg = deg_of_mono;
     }
@@ -347,8 +700,16 @@ bool PolyIsEq(const Poly *p, const Poly *q) {
   else if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
     return p->coeff == q->coeff;
   }
+  else if (PolyIsInline(p) || PolyIsInline(q)) {
+    // Jednomian o stałym współczynniku ma tylko postać bez tablicy.
+    return p->arr == q->arr && p->coeff == q->coeff;
+  }
+  else if (p->arr == q->arr) {
+    return p->size == q->size;
+  }
   else {
-    if (p->size != q->size)
+    // Równe poziomy z tablicy unikatowej są tą samą tablicą.
+    if (p->size != q->size || (PolyIsInterned(p) && PolyIsInterned(q)))
       return false;
     for (size_t i = 0; i < p->size; i++)
       if (!MonoIsEq(&(p->arr[i]), &(q->arr[i])))
@@ -377,26 +738,154 @@ static poly_coeff_t power(poly_coeff_t base, poly_exp_t exp) {
     return base * power(base, exp - 1);
 }
 
+static Poly PolySumMonosOwn(size_t count, Mono *arr);
+
+/**
+ * Sumuje wielomiany będące współczynnikami podanych jednomianów. Wielomiany
+ * będące współczynnikami są sumowane bezpośrednio, a jednomiany pozostałych
+ * wielomianów są zbierane do jednej tablicy i sumowane jednokrotnie.
+ * Przejmuje na własność zawartość jednomianów, ale nie samą tablicę.
+ * @param[in] count : liczba jednomianów
+ * @param[in] monos : tablica jednomianów
+ * @return suma współczynników jednomianów
+ */
+static Poly PolySumOwn(size_t count, Mono monos[]) {
+  poly_coeff_t coeff = 0;
+  size_t size = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (PolyIsCoeff(&(monos[i].p)))
+      coeff += monos[i].p.coeff;
+    else
+      size += PolySize(&(monos[i].p));
+  }
+  if (size == 0)
+    return PolyFromCoeff(coeff);
+
+  Mono *arr = PolyMonosAlloc(size + 1);
+  size_t next = 0;
+  for (size_t i = 0; i < count; i++)
+    if (!PolyIsCoeff(&(monos[i].p)))
+      next += PolyMoveMonos(&(monos[i].p), arr + next);
+  if (coeff != 0)
+    arr[next++] = (Mono) {.p = PolyFromCoeff(coeff), .exp = 0};
+  return PolySumMonosOwn(next, arr);
+}
+
+/**
+ * Sumuje jednomiany o dowolnej kolejności wykładników. W odróżnieniu od
+ * PolyCorrect wszystkie jednomiany o równym wykładniku są sumowane naraz,
+ * więc koszt nie zależy kwadratowo od ich liczby.
+ * Przejmuje na własność tablicę @p arr i jej zawartość.
+ * @param[in] count : liczba jednomianów
+ * @param[in] arr : tablica jednomianów
+ * @return wielomian w jednoznacznej, uporządkowanej postaci
+ */
+static Poly PolySumMonosOwn(size_t count, Mono *arr) {
+  qsort(arr, count, sizeof(Mono), MonoCompByExp);
+  size_t next = 0;
+  for (size_t i = 0; i < count;) {
+    poly_exp_t exp = arr[i].exp;
+    size_t j = i + 1;
+    while (j < count && arr[j].exp == exp)
+      j++;
+    Poly sum = (j == i + 1 ? arr[i].p : PolySumOwn(j - i, arr + i));
+    if (!PolyIsZero(&sum))
+      arr[next++] = MonoFromPoly(&sum, exp);
+    i = j;
+  }
+  return PolyFromSortedMonos(next, count, arr);
+}
+
 Poly PolyAt(const Poly *p, poly_coeff_t x) {
-  Poly multiplied;
+  if (PolyIsCoeff(p))
+    return PolyClone(p);
 
-  if (PolyIsCoeff(p)) {
-    multiplied = PolyClone(p);
+  Mono buffer;
+  const Mono *p_arr = PolyMonos(p, &buffer);
+  size_t p_size = PolySize(p);
+  size_t capacity = 1;
+  for (size_t i = 0; i < p_size; i++)
+    if (!PolyIsCoeff(&(p_arr[i].p)))
+      capacity += PolySize(&(p_arr[i].p));
+
+  // Potęgi x są wyliczane przyrostowo z różnic kolejnych wykładników.
+  // Współczynniki liczbowe są sumowane od razu, a jednomiany pozostałych
+  // współczynników są zbierane i sumowane jednokrotnie na końcu.
+  Mono *arr = PolyMonosAlloc(capacity);
+  size_t count = 0;
+  poly_coeff_t coeff = 0;
+  poly_coeff_t x_pow = 1;
+  poly_exp_t prev_exp = 0;
+  for (size_t i = 0; i < p_size; i++) {
+    x_pow *= power(x, p_arr[i].exp - prev_exp);
+    prev_exp = p_arr[i].exp;
+    // Kolejne potęgi są wielokrotnościami tej, więc też są zerowe.
+    if (x_pow == 0)
+      break;
+
+    const Poly *mono_p = &(p_arr[i].p);
+    if (PolyIsCoeff(mono_p)) {
+      coeff += mono_p->coeff * x_pow;
+    }
+    else {
+      Poly multiplier = PolyFromCoeff(x_pow);
+      Poly mono_multiplied = PolyMulByCoeff(mono_p, &multiplier);
+      if (PolyIsCoeff(&mono_multiplied)) {
+        coeff += mono_multiplied.coeff;
+      }
+      else {
+        count += PolyMoveMonos(&mono_multiplied, arr + count);
+      }
+    }
   }
-  else {
-    multiplied = PolyZero();
 
-    for (size_t i = 0; i < p->size; i++) {
-      Poly multiplier = PolyFromCoeff(power(x, p->arr[i].exp));
-      Poly mono_multiplied = PolyMul(&(p->arr[i].p), &multiplier);
-      multiplied = PolyAddAndClean(&multiplied, &mono_multiplied);
-      PolyDestroy(&multiplier);
+  if (count == 0) {
+    PolyMonosFree(arr);
+    return PolyFromCoeff(coeff);
+  }
+  if (coeff != 0)
+    arr[count++] = (Mono) {.p = PolyFromCoeff(coeff), .exp = 0};
+  return PolySumMonosOwn(count, arr);
+}
 
-      multiplied = PolyCorrect(&multiplied);
+/**
+ * Wylicza wartość wielomianu w punkcie, podstawiając w miejsce zmiennej
+ * @f$x_i@f$ wartość @p x[i + index]. Jeśli @f$i + index \geq k@f$,
+ * w miejsce @f$x_i@f$ podstawia @f$0@f$.
+ * @param[in] p : wielomian
+ * @param[in] k : rozmiar tablicy @p x
+ * @param[in] x : wartości kolejnych zmiennych
+ * @param[in] index : indeks wartości w @p x do podstawienia za @f$x_0@f$
+ * @return wartość wielomianu
+ */
+static poly_coeff_t PolyEvalRec(const Poly *p, size_t k,
+                                const poly_coeff_t x[], size_t index) {
+  if (PolyIsCoeff(p))
+    return p->coeff;
+
+  Mono buffer;
+  const Mono *arr = PolyMonos(p, &buffer);
+  if (index >= k) {
+    if (arr[0].exp == 0)
+      return PolyEvalRec(&(arr[0].p), k, x, index + 1);
+    else
+      return 0;
+  }
+  else {
+    // Schemat Hornera po różnicach kolejnych wykładników.
+    size_t i = PolySize(p) - 1;
+    poly_coeff_t value = PolyEvalRec(&(arr[i].p), k, x, index + 1);
+    while (i > 0) {
+      value *= power(x[index], arr[i].exp - arr[i - 1].exp);
+      i--;
+      value += PolyEvalRec(&(arr[i].p), k, x, index + 1);
     }
+    return value * power(x[index], arr[0].exp);
   }
+}
 
-  return multiplied;
+poly_coeff_t PolyEval(const Poly *p, size_t k, const poly_coeff_t x[]) {
+  return PolyEvalRec(p, k, x, 0);
 }
 
 void MonoPrint(const Mono *m) {
@@ -412,11 +901,13 @@ void PolyPrint(const Poly *p) {
     safePrintLong(p->coeff);
   }
   else {
-    for (size_t i = 0; i < p->size - 1; i++) {
-      MonoPrint(&(p->arr[i]));
+    Mono buffer;
+    const Mono *arr = PolyMonos(p, &buffer);
+    for (size_t i = 0; i < PolySize(p) - 1; i++) {
+      MonoPrint(&(arr[i]));
       safePrintChar('+');
     }
-    MonoPrint(&(p->arr[p->size - 1]));
+    MonoPrint(&(arr[PolySize(p) - 1]));
   }
 }
 
@@ -445,36 +936,172 @@ static Poly PolyPower(const Poly *p, poly_exp_t exp) {
   }
 }
 
+/**
+ * Daje potęgę wielomianu @p composer->q[var], wyliczając ją, jeśli nie była
+ * jeszcze zapamiętana. Brakująca potęga jest wyliczana z największej
+ * zapamiętanej potęgi o mniejszym wykładniku. Zwracany wskaźnik jest ważny do
+ * następnego wywołania tej funkcji dla tej samej zmiennej.
+ * @param[in] composer : obiekt składający
+ * @param[in] var : numer zmiennej mniejszy od @p composer->k
+ * @param[in] exp : dodatni wykładnik
+ * @return @f$q_{var}^{exp}@f$
+ */
+static const Poly *PolyComposerPower(PolyComposer *composer, size_t var,
+                                     poly_exp_t exp) {
+  assert(var < composer->k && exp > 0);
+  if (var >= composer->num_of_powers) {
+    composer->powers = (PolyPowers *)safeRealloc(composer->powers,
+      (var + 1) * sizeof(PolyPowers));
+    for (size_t i = composer->num_of_powers; i <= var; i++)
+      composer->powers[i] = (PolyPowers) {.arr = NULL, .size = 0,
+                                          .capacity = 0};
+    composer->num_of_powers = var + 1;
+  }
+
+  PolyPowers *powers = &(composer->powers[var]);
+  size_t begin = 0, end = powers->size;
+  while (begin < end) {
+    size_t mid = (begin + end) / 2;
+    if (powers->arr[mid].exp < exp)
+      begin = mid + 1;
+    else
+      end = mid;
+  }
+  if (begin < powers->size && powers->arr[begin].exp == exp)
+    return &(powers->arr[begin].p);
+
+  // Potęgi są zapamiętywane między wywołaniami, więc nie mogą korzystać
+  // z obszaru operacji.
+  PolyArena *arena = PolyArenaSuspend();
+  Poly power;
+  if (begin == 0) {
+    power = PolyPower(&(composer->q[var]), exp);
+  }
+  else {
+    Poly gap_power = PolyPower(&(composer->q[var]),
+                               exp - powers->arr[begin - 1].exp);
+    power = PolyMul(&(powers->arr[begin - 1].p), &gap_power);
+    PolyDestroy(&gap_power);
+  }
+  PolyArenaResume(arena);
+
+  if (powers->size == powers->capacity) {
+    powers->capacity = 2 * powers->capacity + 1;
+    powers->arr = (Mono *)safeRealloc(powers->arr,
+                                      powers->capacity * sizeof(Mono));
+  }
+  memmove(powers->arr + begin + 1, powers->arr + begin,
+          (powers->size - begin) * sizeof(Mono));
+  // Potęga może być zerowa, więc nie tworzymy jej przez MonoFromPoly.
+  powers->arr[begin] = (Mono) {.p = power, .exp = exp};
+  powers->size++;
+  return &(powers->arr[begin].p);
+}
+
 /**
  * Wylicza złożenie wielomianu @p p.
- * W miejsce zmiennej @f$x_i@f$ podstawia wielomian @p q[i + index].
- * Jeśli @f$i + index >= k@f$, w miejsce @f$x_i@f$ podstawia @f$0@f$.
+ * W miejsce zmiennej @f$x_i@f$ podstawia wielomian @p q[i + index] obiektu
+ * składającego. Jeśli @f$i + index >= k@f$, w miejsce @f$x_i@f$ podstawia
+ * @f$0@f$.
+ * @param[in] composer : obiekt składający
  * @param[in] p : wielomian
- * @param[in] k : rozmiar tablicy @p q
- * @param[in] q : tablica wielomianów do podstawienia w miejsce zmiennych $p p
  * @param[in] index : indeks wielomianu w @p q do podstawienia za @f$x_0@f$
  * @return @f$p(q_0, q_1, \ldots, q_{k-1})@f$
  */
-static Poly PolyComposeRec(const Poly *p, size_t k, const Poly q[], int index) {
-  if (PolyIsCoeff(p)) {
+static Poly PolyComposeRec(PolyComposer *composer, const Poly *p,
+                           size_t index) {
+  if (PolyIsCoeff(p))
     return PolyFromCoeff(p->coeff);
+
+  Mono buffer;
+  const Mono *arr = PolyMonos(p, &buffer);
+  if (index >= composer->k) {
+    // W miejsce x_index podstawiamy 0, więc zostaje tylko wyraz wolny.
+    if (arr[0].exp == 0)
+      return PolyComposeRec(composer, &(arr[0].p), index + 1);
+    else
+      return PolyZero();
   }
   else {
-    Poly result = PolyZero();
-    for (size_t i = 0; i < p->size; i++) {
-      Poly w_1 = PolyComposeRec(&((p->arr[i]).p), k, q, index + 1);
-      Poly base = (index >= (int)k ? PolyZero() : PolyClone(&(q[index])));
-      Poly w_2 = PolyPower(&base, p->arr[i].exp);
-      Poly w = PolyMul(&w_1, &w_2);
-      PolyDestroy(&w_1);
-      PolyDestroy(&base);
-      PolyDestroy(&w_2);
-      result = PolyAddAndClean(&result, &w);
+    // Składniki są sumowane jednokrotnie na końcu.
+    Mono *terms = (Mono *)safeMalloc(PolySize(p) * sizeof(Mono));
+    size_t count = 0;
+    for (size_t i = 0; i < PolySize(p); i++) {
+      if (arr[i].exp == 0) {
+        terms[count++] = (Mono) {
+          .p = PolyComposeRec(composer, &(arr[i].p), index + 1), .exp = 0
+        };
+        continue;
+      }
+
+      const Poly *power = PolyComposerPower(composer, index, arr[i].exp);
+      // Kolejne potęgi są wielokrotnościami tej, więc też są zerowe.
+      if (PolyIsZero(power))
+        break;
+      // Rekurencja korzysta tylko z potęg kolejnych zmiennych, więc nie
+      // unieważnia wskaźnika power.
+      Poly w = PolyComposeRec(composer, &(arr[i].p), index + 1);
+      terms[count++] = (Mono) {.p = PolyMul(&w, power), .exp = 0};
+      PolyDestroy(&w);
     }
-    return PolyCorrect(&result);
+    Poly result = PolySumOwn(count, terms);
+    free(terms);
+    return result;
   }
 }
 
+/**
+ * Usuwa z pamięci potęgi zapamiętane przez obiekt składający.
+ * @param[in] composer : obiekt składający
+ */
+static void PolyComposerDestroyPowers(PolyComposer *composer) {
+  for (size_t i = 0; i < composer->num_of_powers; i++) {
+    for (size_t j = 0; j < composer->powers[i].size; j++)
+      MonoDestroy(&(composer->powers[i].arr[j]));
+    free(composer->powers[i].arr);
+  }
+  free(composer->powers);
+}
+
 Poly PolyCompose(const Poly *p, size_t k, const Poly q[]) {
-  return PolyComposeRec(p, k, q, 0);
-}
\ No newline at end of file
+  // Jednorazowy obiekt składający nie kopiuje tablicy q, bo jej nie modyfikuje
+  // i nie przeżywa tego wywołania.
+  PolyComposer composer = {.k = k, .q = (Poly *)q, .powers = NULL,
+                           .num_of_powers = 0};
+  Poly result = PolyComposerApply(&composer, p);
+  PolyComposerDestroyPowers(&composer);
+  return result;
+}
+
+PolyComposer PolyComposerNew(size_t k, const Poly q[]) {
+  PolyComposer composer = {.k = k, .q = NULL, .powers = NULL,
+                           .num_of_powers = 0};
+  if (k > 0) {
+    composer.q = (Poly *)safeMalloc(k * sizeof(Poly));
+    for (size_t i = 0; i < k; i++)
+      composer.q[i] = PolyClone(&(q[i]));
+  }
+  return composer;
+}
+
+void PolyComposerDestroy(PolyComposer *composer) {
+  PolyComposerDestroyPowers(composer);
+  for (size_t i = 0; i < composer->k; i++)
+    PolyDestroy(&(composer->q[i]));
+  free(composer->q);
+}
+
+Poly PolyComposerApply(PolyComposer *composer, const Poly *p) {
+  // Tymczasowe iloczyny i sumy powstają w obszarze, z którego wychodzi
+  // jedynie kopia wyniku.
+  PolyArena arena;
+  PolyArenaBegin(&arena, ARENA_HUGE_PAGES);
+  Poly result = PolyComposeRec(composer, p, 0);
+  return PolyArenaEnd(&arena, &result);
+}
+
+void PolyComposerApplyBatch(PolyComposer *composer, size_t count,
+                            const Poly p[], Poly results[]) {
+  for (size_t i = 0; i < count; i++)
+    results[i] = PolyComposerApply(composer, &(p[i]));
+}
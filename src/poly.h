@@ -15,6 +15,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /** To jest typ reprezentujący współczynniki. */
 typedef long poly_coeff_t;
@@ -28,6 +29,13 @@ struct Mono;
  * To jest struktura przechowująca wielomian.
  * Wielomian jest albo liczbą całkowitą, czyli wielomianem stałym
  * (wtedy `arr == NULL`), albo niepustą listą jednomianów (wtedy `arr != NULL`).
+ * Wielomian będący jednym jednomianem @f$cx_i^e@f$ o stałym współczynniku
+ * @f$c@f$ i dodatnim wykładniku @f$e@f$ jest przechowywany bez tablicy
+ * jednomianów: @p coeff jest współczynnikiem @f$c@f$, a @p arr nie wskazuje
+ * pamięci, tylko przechowuje wykładnik @f$e@f$ z ustawionym najmłodszym bitem.
+ * Jest to zmiana interfejsu: jednomiany wielomianu niebędącego
+ * współczynnikiem należy odczytywać przez PolySize i PolyMonos, a nie
+ * bezpośrednio przez @p size i @p arr.
  */
 typedef struct Poly {
   /**
@@ -113,6 +121,52 @@ static inline bool PolyIsZero(const Poly *p) {
   return PolyIsCoeff(p) && p->coeff == 0;
 }
 
+/**
+ * Sprawdza, czy wielomian jest jednomianem @f$cx_i^e@f$ przechowywanym bez
+ * tablicy jednomianów.
+ * @param[in] p : wielomian
+ * @return czy wielomian jest przechowywany bez tablicy?
+ */
+static inline bool PolyIsInline(const Poly *p) {
+  return ((uintptr_t)p->arr & 1) != 0;
+}
+
+/**
+ * Daje wykładnik wielomianu przechowywanego bez tablicy jednomianów.
+ * @param[in] p : wielomian @f$cx_i^e@f$
+ * @return wykładnik @f$e@f$
+ */
+static inline poly_exp_t PolyInlineExp(const Poly *p) {
+  assert(PolyIsInline(p));
+  return (poly_exp_t)((uintptr_t)p->arr >> 1);
+}
+
+/**
+ * Daje liczbę jednomianów wielomianu niebędącego współczynnikiem.
+ * @param[in] p : wielomian
+ * @return liczba jednomianów
+ */
+static inline size_t PolySize(const Poly *p) {
+  assert(!PolyIsCoeff(p));
+  return PolyIsInline(p) ? 1 : p->size;
+}
+
+/**
+ * Udostępnia jednomiany wielomianu niebędącego współczynnikiem w postaci
+ * tablicy. Jednomian wielomianu przechowywanego bez tablicy jest zapisywany
+ * w @p buffer.
+ * @param[in] p : wielomian
+ * @param[in] buffer : miejsce na jednomian
+ * @return tablica PolySize(p) jednomianów
+ */
+static inline const Mono *PolyMonos(const Poly *p, Mono *buffer) {
+  assert(!PolyIsCoeff(p));
+  if (!PolyIsInline(p))
+    return p->arr;
+  *buffer = (Mono) {.p = PolyFromCoeff(p->coeff), .exp = PolyInlineExp(p)};
+  return buffer;
+}
+
 /**
  * Usuwa wielomian z pamięci.
  * @param[in] p : wielomian
@@ -128,14 +182,31 @@ static inline void MonoDestroy(Mono *m) {
 }
 
 /**
- * Robi pełną, głęboką kopię wielomianu.
+ * Robi kopię wielomianu w stałym czasie. Kopia współdzieli tablicę
+ * jednomianów z oryginałem, a operacje przejmujące jeden z nich na własność
+ * kopiują ją przed modyfikacją.
  * @param[in] p : wielomian
  * @return skopiowany wielomian
  */
 Poly PolyClone(const Poly *p);
 
 /**
- * Robi pełną, głęboką kopię jednomianu.
+ * Robi głęboką kopię wielomianu w jednym bloku pamięci. Poziomy kopii są
+ * ułożone w bloku w kolejności przeszukiwania w głąb, więc przeglądanie kopii
+ * odwołuje się do kolejnych adresów. Poziomy współdzielone przez kilka
+ * jednomianów oryginału są kopiowane osobno. Poziomy kopii nie mogą być
+ * modyfikowane w miejscu, a blok jest zwalniany jednym wywołaniem wraz
+ * z ostatnim odwołaniem do któregokolwiek z nich.
+ * Biblioteka nie wywołuje tej funkcji sama: korzysta z niej użytkownik dla
+ * wielomianu, który będzie wielokrotnie przeglądany, a nie modyfikowany
+ * (zob. pomiar w programie poly_bench).
+ * @param[in] p : wielomian
+ * @return skopiowany wielomian
+ */
+Poly PolyCloneContiguous(const Poly *p);
+
+/**
+ * Robi kopię jednomianu w stałym czasie.
  * @param[in] m : jednomian
  * @return skopiowany jednomian
  */
@@ -151,6 +222,17 @@ static inline Mono MonoClone(const Mono *m) {
  */
 Poly PolyAdd(const Poly *p, const Poly *q);
 
+/**
+ * Dodaje dwa wielomiany, przejmując je na własność. Może wykorzystać tablice
+ * jednomianów wielomianów @p p i @p q do zbudowania wyniku, więc po wywołaniu
+ * zawartość struktur wskazywanych przez @p p i @p q nie może być już używana
+ * ani usuwana. Wskaźniki @p p i @p q muszą wskazywać na różne wielomiany.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly PolyAddOwn(Poly *p, Poly *q);
+
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian.
  * Przejmuje na własność zawartość tablicy @p monos.
@@ -191,6 +273,16 @@ Poly PolyCloneMonos(size_t count, const Mono monos[]);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Mnoży dwa wielomiany, przejmując je na własność. Po wywołaniu zawartość
+ * struktur wskazywanych przez @p p i @p q nie może być już używana ani
+ * usuwana. Wskaźniki @p p i @p q muszą wskazywać na różne wielomiany.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly PolyMulOwn(Poly *p, Poly *q);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian @f$p@f$
@@ -198,6 +290,15 @@ Poly PolyMul(const Poly *p, const Poly *q);
  */
 Poly PolyNeg(const Poly *p);
 
+/**
+ * Zwraca przeciwny wielomian, przejmując @p p na własność. Neguje
+ * współczynniki w miejscu, nie alokując pamięci. Po wywołaniu zawartość
+ * struktury wskazywanej przez @p p nie może być już używana ani usuwana.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$-p@f$
+ */
+Poly PolyNegOwn(Poly *p);
+
 /**
  * Odejmuje wielomian od wielomianu.
  * @param[in] p : wielomian @f$p@f$
@@ -206,6 +307,16 @@ Poly PolyNeg(const Poly *p);
  */
 Poly PolySub(const Poly *p, const Poly *q);
 
+/**
+ * Odejmuje wielomian od wielomianu, przejmując je na własność. Po wywołaniu
+ * zawartość struktur wskazywanych przez @p p i @p q nie może być już używana
+ * ani usuwana. Wskaźniki @p p i @p q muszą wskazywać na różne wielomiany.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolySubOwn(Poly *p, Poly *q);
+
 /**
  * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
  * tożsamościowo równego zeru). Zmienne indeksowane są od 0.
@@ -254,6 +365,33 @@ bool MonoIsEq(const Mono *m, const Mono *n);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartość wielomianu w punkcie @f$(x_0, x_1, \ldots, x_{k-1})@f$.
+ * Jeśli @f$i \geq k@f$, w miejsce @f$x_i@f$ podstawia @f$0@f$. Wynik jest
+ * taki sam jak po @f$k@f$ wywołaniach PolyAt, ale nie są tworzone żadne
+ * pośrednie wielomiany.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] k : rozmiar tablicy @p x
+ * @param[in] x : wartości kolejnych zmiennych
+ * @return @f$p(x_0, x_1, \ldots, x_{k-1})@f$
+ */
+poly_coeff_t PolyEval(const Poly *p, size_t k, const poly_coeff_t x[]);
+
+/**
+ * Wylicza wartości wielomianu w @p n punktach, tak jak PolyEval. Wartość
+ * zmiennej @f$x_i@f$ w punkcie @f$j@f$ jest zapisana w
+ * @p points[j * k + i]. Punkty są przetwarzane blokami, dla których drzewo
+ * jednomianów jest przechodzone jednokrotnie, a obliczenia dla punktów bloku
+ * są wykonywane wektorowo, jeśli procesor to umożliwia.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] k : liczba współrzędnych każdego punktu
+ * @param[in] n : liczba punktów
+ * @param[in] points : współrzędne kolejnych punktów
+ * @param[out] out : tablica na @p n wartości wielomianu
+ */
+void PolyEvalBatch(const Poly *p, size_t k, size_t n,
+                   const poly_coeff_t points[], poly_coeff_t out[]);
+
 /**
  * Wypisuje jednomian na standardowe wyjście.
  * @param[in] m : jednomian @f$m@f$
@@ -277,4 +415,63 @@ void PolyPrint(const Poly *p);
  */
 Poly PolyCompose(const Poly *p, size_t k, const Poly q[]);
 
+/**
+ * To jest struktura przechowująca wyliczone dotąd potęgi wielomianu
+ * @f$q@f$. Potęga @f$q^n@f$ jest przechowywana jako jednomian o współczynniku
+ * @f$q^n@f$ i wykładniku @f$n@f$. Jednomiany są posortowane rosnąco po
+ * wykładnikach, a wykładniki są dodatnie.
+ */
+typedef struct PolyPowers {
+  Mono *arr; ///< tablica potęg
+  size_t size; ///< liczba wyliczonych potęg
+  size_t capacity; ///< rozmiar tablicy @p arr
+} PolyPowers;
+
+/**
+ * To jest struktura pozwalająca składać wiele wielomianów z tą samą tablicą
+ * wielomianów @f$q_0, q_1, \ldots, q_{k-1}@f$. Potęgi wielomianów @f$q_i@f$
+ * są wyliczane w miarę potrzeby i współdzielone przez kolejne złożenia.
+ */
+typedef struct PolyComposer {
+  size_t k; ///< rozmiar tablicy @p q
+  Poly *q; ///< kopie wielomianów podstawianych w miejsce zmiennych
+  PolyPowers *powers; ///< potęgi wielomianów @p q wyliczone dotąd
+  size_t num_of_powers; ///< rozmiar tablicy @p powers
+} PolyComposer;
+
+/**
+ * Tworzy obiekt składający wielomiany z tablicą wielomianów @p q.
+ * Kopiuje wielomiany z tablicy @p q.
+ * @param[in] k : rozmiar tablicy @p q
+ * @param[in] q : tablica wielomianów do podstawienia w miejsce zmiennych
+ * @return obiekt składający
+ */
+PolyComposer PolyComposerNew(size_t k, const Poly q[]);
+
+/**
+ * Usuwa z pamięci obiekt składający wraz z zapamiętanymi potęgami.
+ * @param[in] composer : obiekt składający
+ */
+void PolyComposerDestroy(PolyComposer *composer);
+
+/**
+ * Wylicza złożenie wielomianu @p p, tak jak PolyCompose, z tablicą wielomianów
+ * obiektu składającego. Zapamiętuje wyliczone potęgi do kolejnych złożeń.
+ * @param[in] composer : obiekt składający
+ * @param[in] p : wielomian
+ * @return @f$p(q_0, q_1, \ldots, q_{k-1})@f$
+ */
+Poly PolyComposerApply(PolyComposer *composer, const Poly *p);
+
+/**
+ * Wylicza złożenia wszystkich wielomianów z tablicy @p p z tablicą
+ * wielomianów obiektu składającego.
+ * @param[in] composer : obiekt składający
+ * @param[in] count : rozmiar tablic @p p i @p results
+ * @param[in] p : tablica wielomianów
+ * @param[out] results : tablica na złożenia kolejnych wielomianów z @p p
+ */
+void PolyComposerApplyBatch(PolyComposer *composer, size_t count,
+                            const Poly p[], Poly results[]);
+
 #endif /* __POLY_H__ */
\ No newline at end of file
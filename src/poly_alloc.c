@@ -0,0 +1,866 @@
+/** @file
+  Implementacja modułu przydzielającego pamięć na tablice jednomianów
+  wielomianów
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+// Poniższa dyrektywa zapewnia dostępność funkcji mmap i madvise.
+#define _GNU_SOURCE
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "poly_alloc.h"
+#include "poly_intern.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#ifdef POLY_POOL
+#include <pthread.h>
+#endif
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+/** Obszary mogą korzystać z przezroczystych dużych stron. */
+#define ARENA_HUGE_PAGES_ENABLED 1
+#else
+/** Przezroczyste duże strony nie są dostępne na tej platformie. */
+#define ARENA_HUGE_PAGES_ENABLED 0
+#endif
+
+/** Rozmiar pierwszego bloku obszaru w bajtach. */
+#define ARENA_MIN_CHUNK_SIZE (64 * 1024)
+
+/** Rozmiar dużej strony, od którego bloki mogą korzystać z dużych stron. */
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/** Oznacza brak zapamiętanego ostatniego przydziału w bloku. */
+#define ARENA_NO_LAST SIZE_MAX
+
+/**
+ * To jest nagłówek poprzedzający każdą tablicę jednomianów.
+ * Unia z max_align_t zapewnia wyrównanie tablicy za nagłówkiem.
+ */
+typedef union MonosHeader {
+  struct {
+    union {
+      size_t size; ///< rozmiar tablicy z obszaru w bajtach
+      size_t size_class; ///< klasa rozmiaru tablicy z puli albo POOL_LARGE
+    };
+    atomic_size_t refs; ///< liczba odwołań do tablicy
+    /**
+     * czy tablica jest w tablicy unikatowej? Inne wątki, na przykład przy
+     * mnożeniu współbieżnym, odczytują znacznik bez muteksu tablicy
+     * unikatowej.
+     */
+    atomic_bool is_interned;
+    bool is_in_arena; ///< czy tablica pochodzi z obszaru?
+    union {
+      /**
+       * Nagłówek bloku kopii z PolyCloneContiguous, w którym leży tablica
+       * spoza obszaru, albo NULL. Odwołania do tablic bloku są liczone
+       * w jego nagłówku.
+       */
+      union MonosHeader *block;
+      /** blok obszaru, w którym leży tablica z obszaru */
+      struct PolyArenaChunk *chunk;
+    };
+  };
+  max_align_t align; ///< wyrównanie
+} MonosHeader;
+
+/**
+ * Daje nagłówek tablicy jednomianów.
+ * @param[in] arr : tablica jednomianów
+ * @return nagłówek tablicy
+ */
+static inline MonosHeader *MonosHeaderOf(const Mono *arr) {
+  return (MonosHeader *)arr - 1;
+}
+
+/**
+ * To jest struktura przechowująca jeden blok pamięci obszaru.
+ */
+struct PolyArenaChunk {
+  struct PolyArenaChunk *next; ///< starszy blok albo NULL
+  PolyArena *arena; ///< obszar, do którego należy blok
+  size_t size; ///< rozmiar tablicy @p data w bajtach
+  size_t used; ///< liczba zajętych bajtów tablicy @p data
+  size_t last; ///< przesunięcie nagłówka ostatniego przydziału
+  bool is_mapped; ///< czy blok został przydzielony przez mmap?
+  max_align_t data[]; ///< pamięć bloku
+};
+
+/**
+ * Przydziela pamięć funkcją malloc, ignorując kontekst.
+ * @param[in] context : kontekst
+ * @param[in] size : liczba bajtów
+ * @return przydzielona pamięć albo NULL
+ */
+static void *DefaultMalloc(void *context, size_t size) {
+  (void)context;
+  return malloc(size);
+}
+
+/**
+ * Zmienia rozmiar pamięci funkcją realloc, ignorując kontekst.
+ * @param[in] context : kontekst
+ * @param[in] ptr : pamięć
+ * @param[in] size : liczba bajtów
+ * @return pamięć, być może pod innym adresem, albo NULL
+ */
+static void *DefaultRealloc(void *context, void *ptr, size_t size) {
+  (void)context;
+  return realloc(ptr, size);
+}
+
+/**
+ * Zwalnia pamięć funkcją free, ignorując kontekst.
+ * @param[in] context : kontekst
+ * @param[in] ptr : pamięć
+ */
+static void DefaultFree(void *context, void *ptr) {
+  (void)context;
+  free(ptr);
+}
+
+/** Domyślny alokator korzystający z biblioteki standardowej. */
+static const PolyAllocator default_allocator = {
+  .malloc_fn = DefaultMalloc, .realloc_fn = DefaultRealloc,
+  .free_fn = DefaultFree, .context = NULL
+};
+
+/** Alokator, z którego pochodzi cała pamięć przydzielana przez moduł. */
+static PolyAllocator allocator = {
+  .malloc_fn = DefaultMalloc, .realloc_fn = DefaultRealloc,
+  .free_fn = DefaultFree, .context = NULL
+};
+
+/**
+ * Przydziela pamięć alokatorem. Tak jak safeMalloc kończy program kodem 1,
+ * jeśli się to nie uda.
+ * @param[in] size : liczba bajtów
+ * @return przydzielona pamięć
+ */
+static void *AllocatorMalloc(size_t size) {
+  void *ptr = allocator.malloc_fn(allocator.context, size);
+  if (ptr == NULL)
+    exit(1);
+  return ptr;
+}
+
+/**
+ * Zmienia rozmiar pamięci przydzielonej alokatorem. Tak jak safeRealloc
+ * kończy program kodem 1, jeśli się to nie uda.
+ * @param[in] ptr : pamięć
+ * @param[in] size : liczba bajtów
+ * @return pamięć, być może pod innym adresem
+ */
+static void *AllocatorRealloc(void *ptr, size_t size) {
+  ptr = allocator.realloc_fn(allocator.context, ptr, size);
+  if (ptr == NULL)
+    exit(1);
+  return ptr;
+}
+
+/**
+ * Zwalnia pamięć przydzieloną alokatorem.
+ * @param[in] ptr : pamięć
+ */
+static inline void AllocatorFree(void *ptr) {
+  allocator.free_fn(allocator.context, ptr);
+}
+
+void PolySetAllocator(const PolyAllocator *new_allocator) {
+  allocator = new_allocator != NULL ? *new_allocator : default_allocator;
+}
+
+PolyAllocator PolyGetAllocator(void) {
+  return allocator;
+}
+
+#ifdef POLY_POOL
+
+/** Liczba klas rozmiarów tablic przydzielanych z puli. */
+#define POOL_NUM_OF_CLASSES 8
+
+/** Największa liczba jednomianów tablicy przydzielanej z puli. */
+#define POOL_MAX_MONOS 16
+
+/**
+ * Liczba bloków przenoszonych naraz między pamięcią podręczną wątku a pulą
+ * wspólną dla wszystkich wątków.
+ */
+#define POOL_BATCH 32
+
+/** Klasa rozmiaru oznaczająca tablicę przydzieloną przez malloc. */
+#define POOL_LARGE POOL_NUM_OF_CLASSES
+
+/** Liczby jednomianów mieszczące się w blokach kolejnych klas. */
+static const size_t pool_class_monos[POOL_NUM_OF_CLASSES] = {
+  1, 2, 3, 4, 6, 8, 12, 16
+};
+
+/** Klasy rozmiarów dla kolejnych liczb jednomianów. */
+static const unsigned char pool_class_of[POOL_MAX_MONOS + 1] = {
+  0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7
+};
+
+/**
+ * To jest struktura przechowująca wolny blok na liście wolnych bloków.
+ */
+typedef struct PoolBlock {
+  struct PoolBlock *next; ///< następny wolny blok
+} PoolBlock;
+
+/**
+ * To jest struktura przechowująca listy wolnych bloków wszystkich klas.
+ */
+typedef struct PoolLists {
+  PoolBlock *free[POOL_NUM_OF_CLASSES]; ///< listy wolnych bloków
+  size_t count[POOL_NUM_OF_CLASSES]; ///< długości list wolnych bloków
+} PoolLists;
+
+/**
+ * To jest struktura przechowująca pamięć podręczną puli w jednym wątku.
+ */
+typedef struct PoolCache {
+  PoolLists lists; ///< wolne bloki wątku
+  PolyAllocStats stats; ///< statystyki wątku
+  bool is_registered; ///< czy wątek zwróci bloki do puli po zakończeniu?
+} PoolCache;
+
+/** Pamięć podręczna puli bieżącego wątku. */
+static _Thread_local PoolCache pool_cache;
+
+/** Pula wspólna dla wszystkich wątków. */
+static PoolLists pool_global;
+
+/** Statystyki zakończonych wątków. */
+static PolyAllocStats pool_global_stats;
+
+/** Chroni pulę wspólną i statystyki zakończonych wątków. */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Klucz, którego destruktor zwraca bloki kończącego się wątku do puli. */
+static pthread_key_t pool_key;
+
+/** Zapewnia jednokrotne utworzenie klucza @p pool_key. */
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Wyznacza rozmiar bloku klasy wraz z nagłówkiem.
+ * @param[in] size_class : klasa rozmiaru
+ * @return rozmiar bloku w bajtach
+ */
+static inline size_t PoolBlockSize(size_t size_class) {
+  size_t bytes = sizeof(MonosHeader) +
+                 pool_class_monos[size_class] * sizeof(Mono);
+  return (bytes + sizeof(MonosHeader) - 1) / sizeof(MonosHeader) *
+         sizeof(MonosHeader);
+}
+
+/**
+ * Przenosi co najwyżej @p count bloków klasy między listami.
+ * @param[in,out] from : listy, z których zabierane są bloki
+ * @param[in,out] to : listy, do których dokładane są bloki
+ * @param[in] size_class : klasa rozmiaru
+ * @param[in] count : liczba bloków
+ */
+static void PoolMove(PoolLists *from, PoolLists *to, size_t size_class,
+                     size_t count) {
+  while (count-- > 0 && from->free[size_class] != NULL) {
+    PoolBlock *block = from->free[size_class];
+    from->free[size_class] = block->next;
+    from->count[size_class]--;
+    block->next = to->free[size_class];
+    to->free[size_class] = block;
+    to->count[size_class]++;
+  }
+}
+
+/**
+ * Dodaje statystyki @p add do statystyk @p stats.
+ * @param[in,out] stats : statystyki
+ * @param[in] add : statystyki
+ */
+static void PoolStatsAdd(PolyAllocStats *stats, const PolyAllocStats *add) {
+  stats->pool_allocs += add->pool_allocs;
+  stats->pool_refills += add->pool_refills;
+  stats->pool_slabs += add->pool_slabs;
+  stats->large_allocs += add->large_allocs;
+}
+
+/**
+ * Zwraca do puli wspólnej wszystkie bloki kończącego się wątku.
+ * @param[in] arg : pamięć podręczna wątku
+ */
+static void PoolCacheRelease(void *arg) {
+  PoolCache *cache = (PoolCache *)arg;
+  pthread_mutex_lock(&pool_mutex);
+  for (size_t c = 0; c < POOL_NUM_OF_CLASSES; c++)
+    PoolMove(&(cache->lists), &pool_global, c, cache->lists.count[c]);
+  PoolStatsAdd(&pool_global_stats, &(cache->stats));
+  pthread_mutex_unlock(&pool_mutex);
+  cache->stats = (PolyAllocStats) {0};
+}
+
+/** Tworzy klucz @p pool_key. */
+static void PoolKeyCreate(void) {
+  pthread_key_create(&pool_key, PoolCacheRelease);
+}
+
+/**
+ * Rejestruje pamięć podręczną bieżącego wątku, aby jej bloki wróciły do puli
+ * wspólnej po zakończeniu wątku.
+ */
+static inline void PoolRegister(void) {
+  if (!pool_cache.is_registered) {
+    pthread_once(&pool_key_once, PoolKeyCreate);
+    pthread_setspecific(pool_key, &pool_cache);
+    pool_cache.is_registered = true;
+  }
+}
+
+/**
+ * Uzupełnia pamięć podręczną wątku o bloki klasy, najpierw z puli wspólnej,
+ * a jeśli jest pusta, z nowego bloku pamięci przydzielonego przez malloc.
+ * @param[in] size_class : klasa rozmiaru
+ */
+static void PoolRefill(size_t size_class) {
+  PoolRegister();
+  pool_cache.stats.pool_refills++;
+
+  pthread_mutex_lock(&pool_mutex);
+  PoolMove(&pool_global, &(pool_cache.lists), size_class, POOL_BATCH);
+  pthread_mutex_unlock(&pool_mutex);
+  if (pool_cache.lists.free[size_class] != NULL)
+    return;
+
+  // Bloki nowego fragmentu pamięci nie są nigdy zwracane systemowi, tylko
+  // krążą między wątkami a pulą wspólną.
+  pool_cache.stats.pool_slabs++;
+  size_t block_size = PoolBlockSize(size_class);
+  char *slab = (char *)AllocatorMalloc(POOL_BATCH * block_size);
+  for (size_t i = 0; i < POOL_BATCH; i++) {
+    PoolBlock *block = (PoolBlock *)(slab + i * block_size);
+    block->next = pool_cache.lists.free[size_class];
+    pool_cache.lists.free[size_class] = block;
+  }
+  pool_cache.lists.count[size_class] += POOL_BATCH;
+}
+
+/**
+ * Przydziela tablicę jednomianów poza obszarem.
+ * @param[in] count : dodatnia liczba jednomianów
+ * @return tablica jednomianów
+ */
+static Mono *HeapAlloc(size_t count) {
+  MonosHeader *header;
+  if (count > POOL_MAX_MONOS) {
+    pool_cache.stats.large_allocs++;
+    header = (MonosHeader *)AllocatorMalloc(sizeof(MonosHeader) +
+                                            count * sizeof(Mono));
+    header->size_class = POOL_LARGE;
+  }
+  else {
+    size_t size_class = pool_class_of[count];
+    if (pool_cache.lists.free[size_class] == NULL)
+      PoolRefill(size_class);
+    pool_cache.stats.pool_allocs++;
+    PoolBlock *block = pool_cache.lists.free[size_class];
+    pool_cache.lists.free[size_class] = block->next;
+    pool_cache.lists.count[size_class]--;
+    header = (MonosHeader *)block;
+    header->size_class = size_class;
+  }
+  return (Mono *)(header + 1);
+}
+
+/**
+ * Zwalnia tablicę jednomianów przydzieloną poza obszarem.
+ * @param[in] arr : tablica jednomianów
+ */
+static void HeapFree(Mono *arr) {
+  MonosHeader *header = (MonosHeader *)arr - 1;
+  size_t size_class = header->size_class;
+  if (size_class == POOL_LARGE) {
+    AllocatorFree(header);
+    return;
+  }
+
+  PoolRegister();
+  PoolBlock *block = (PoolBlock *)header;
+  block->next = pool_cache.lists.free[size_class];
+  pool_cache.lists.free[size_class] = block;
+  // Nadmiar bloków jest oddawany innym wątkom, na przykład gdy jeden wątek
+  // zwalnia wielomiany utworzone przez inne.
+  if (++pool_cache.lists.count[size_class] > 2 * POOL_BATCH) {
+    pthread_mutex_lock(&pool_mutex);
+    PoolMove(&(pool_cache.lists), &pool_global, size_class, POOL_BATCH);
+    pthread_mutex_unlock(&pool_mutex);
+  }
+}
+
+/**
+ * Zmienia rozmiar tablicy jednomianów przydzielonej poza obszarem.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] count : dodatnia liczba jednomianów
+ * @return tablica jednomianów, być może pod innym adresem
+ */
+static Mono *HeapRealloc(Mono *arr, size_t count) {
+  MonosHeader *header = (MonosHeader *)arr - 1;
+  size_t size_class = header->size_class;
+  if (size_class == POOL_LARGE && count > POOL_MAX_MONOS) {
+    header = (MonosHeader *)AllocatorRealloc(header, sizeof(MonosHeader) +
+                                                     count * sizeof(Mono));
+    return (Mono *)(header + 1);
+  }
+  if (size_class != POOL_LARGE && count <= POOL_MAX_MONOS &&
+      pool_class_of[count] == size_class)
+    return arr;
+
+  Mono *res = HeapAlloc(count);
+  size_t old_count = size_class == POOL_LARGE ? count :
+                     pool_class_monos[size_class];
+  memcpy(res, arr, (old_count < count ? old_count : count) * sizeof(Mono));
+  HeapFree(arr);
+  return res;
+}
+
+PolyAllocStats PolyAllocGetStats(void) {
+  pthread_mutex_lock(&pool_mutex);
+  PolyAllocStats stats = pool_global_stats;
+  pthread_mutex_unlock(&pool_mutex);
+  PoolStatsAdd(&stats, &(pool_cache.stats));
+  return stats;
+}
+
+#else
+
+/**
+ * Przydziela tablicę jednomianów poza obszarem.
+ * @param[in] count : dodatnia liczba jednomianów
+ * @return tablica jednomianów
+ */
+static inline Mono *HeapAlloc(size_t count) {
+  MonosHeader *header =
+    (MonosHeader *)AllocatorMalloc(sizeof(MonosHeader) + count * sizeof(Mono));
+  return (Mono *)(header + 1);
+}
+
+/**
+ * Zwalnia tablicę jednomianów przydzieloną poza obszarem.
+ * @param[in] arr : tablica jednomianów
+ */
+static inline void HeapFree(Mono *arr) {
+  AllocatorFree((MonosHeader *)arr - 1);
+}
+
+/**
+ * Zmienia rozmiar tablicy jednomianów przydzielonej poza obszarem.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] count : dodatnia liczba jednomianów
+ * @return tablica jednomianów, być może pod innym adresem
+ */
+static inline Mono *HeapRealloc(Mono *arr, size_t count) {
+  MonosHeader *header =
+    (MonosHeader *)AllocatorRealloc((MonosHeader *)arr - 1,
+                                    sizeof(MonosHeader) + count * sizeof(Mono));
+  return (Mono *)(header + 1);
+}
+
+PolyAllocStats PolyAllocGetStats(void) {
+  return (PolyAllocStats) {0};
+}
+
+#endif /* POLY_POOL */
+
+/** Obszary rozpoczęte w bieżącym wątku, od ostatnio rozpoczętego. */
+static _Thread_local PolyArena *current_arena = NULL;
+
+/** Obszar, z którego są przydzielane tablice, albo NULL. */
+static _Thread_local PolyArena *target_arena = NULL;
+
+/**
+ * Zaokrągla liczbę bajtów w górę do wielokrotności rozmiaru nagłówka.
+ * @param[in] bytes : liczba bajtów
+ * @return zaokrąglona liczba bajtów
+ */
+static inline size_t ArenaRound(size_t bytes) {
+  return (bytes + sizeof(MonosHeader) - 1) / sizeof(MonosHeader) *
+         sizeof(MonosHeader);
+}
+
+/**
+ * Tworzy nowy blok obszaru mieszczący co najmniej @p min_size bajtów.
+ * @param[in,out] arena : obszar
+ * @param[in] min_size : liczba bajtów
+ */
+static void ArenaAddChunk(PolyArena *arena, size_t min_size) {
+  size_t size = arena->next_chunk_size;
+  while (size < min_size)
+    size *= 2;
+  arena->next_chunk_size = 2 * size;
+
+  size_t total = offsetof(struct PolyArenaChunk, data) + size;
+  struct PolyArenaChunk *chunk = NULL;
+  bool is_mapped = false;
+#if ARENA_HUGE_PAGES_ENABLED
+  if (arena->use_huge_pages && total >= ARENA_HUGE_PAGE_SIZE) {
+    total = (total + ARENA_HUGE_PAGE_SIZE - 1) / ARENA_HUGE_PAGE_SIZE *
+            ARENA_HUGE_PAGE_SIZE;
+    void *ptr = mmap(NULL, total, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr != MAP_FAILED) {
+      // Rada dla jądra może zostać odrzucona, co nie przeszkadza w działaniu.
+      madvise(ptr, total, MADV_HUGEPAGE);
+      chunk = (struct PolyArenaChunk *)ptr;
+      size = total - offsetof(struct PolyArenaChunk, data);
+      is_mapped = true;
+    }
+  }
+#endif
+  if (chunk == NULL) {
+    total = offsetof(struct PolyArenaChunk, data) + size;
+    chunk = (struct PolyArenaChunk *)AllocatorMalloc(total);
+  }
+
+  chunk->next = arena->chunks;
+  chunk->arena = arena;
+  chunk->size = size;
+  chunk->used = 0;
+  chunk->last = ARENA_NO_LAST;
+  chunk->is_mapped = is_mapped;
+  arena->chunks = chunk;
+}
+
+/**
+ * Przydziela tablicę z obszaru.
+ * @param[in,out] arena : obszar
+ * @param[in] bytes : rozmiar tablicy w bajtach
+ * @return tablica
+ */
+static void *ArenaAlloc(PolyArena *arena, size_t bytes) {
+  size_t need = sizeof(MonosHeader) + ArenaRound(bytes);
+  struct PolyArenaChunk *chunk = arena->chunks;
+  if (chunk == NULL || chunk->size - chunk->used < need) {
+    ArenaAddChunk(arena, need);
+    chunk = arena->chunks;
+  }
+
+  MonosHeader *header = (MonosHeader *)((char *)chunk->data + chunk->used);
+  header->size = ArenaRound(bytes);
+  chunk->last = chunk->used;
+  chunk->used += need;
+  return header + 1;
+}
+
+/**
+ * Sprawdza, czy tablica jest ostatnim przydziałem w bloku.
+ * @param[in] chunk : blok
+ * @param[in] header : nagłówek tablicy
+ * @return czy tablica jest ostatnim przydziałem?
+ */
+static inline bool ArenaIsLast(const struct PolyArenaChunk *chunk,
+                               const MonosHeader *header) {
+  return chunk->last != ARENA_NO_LAST &&
+         (const char *)chunk->data + chunk->last == (const char *)header;
+}
+
+/**
+ * Ustawia nagłówek nowej tablicy jednomianów: jedno odwołanie, poza tablicą
+ * unikatową i blokiem kopii.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] chunk : blok obszaru, w którym leży tablica, albo NULL
+ * @return tablica @p arr
+ */
+static inline Mono *MonosInit(Mono *arr, struct PolyArenaChunk *chunk) {
+  MonosHeader *header = MonosHeaderOf(arr);
+  atomic_init(&(header->refs), 1);
+  atomic_init(&(header->is_interned), false);
+  header->is_in_arena = chunk != NULL;
+  if (chunk != NULL)
+    header->chunk = chunk;
+  else
+    header->block = NULL;
+  return arr;
+}
+
+/**
+ * Daje nagłówek bloku kopii z PolyCloneContiguous, w którym leży tablica.
+ * @param[in] header : nagłówek tablicy
+ * @return nagłówek bloku albo NULL, jeśli tablica nie leży w bloku kopii
+ */
+static inline MonosHeader *MonosBlockOf(const MonosHeader *header) {
+  return header->is_in_arena ? NULL : header->block;
+}
+
+Mono *PolyMonosAlloc(size_t count) {
+  if (target_arena == NULL)
+    return MonosInit(HeapAlloc(count), NULL);
+  Mono *arr = (Mono *)ArenaAlloc(target_arena, count * sizeof(Mono));
+  return MonosInit(arr, target_arena->chunks);
+}
+
+Mono *PolyMonosRealloc(Mono *arr, size_t count) {
+  if (arr == NULL)
+    return PolyMonosAlloc(count);
+
+  assert(!PolyMonosIsShared(arr));
+  MonosHeader *header = MonosHeaderOf(arr);
+  if (!header->is_in_arena)
+    return MonosInit(HeapRealloc(arr, count), NULL);
+
+  // Nagłówek tablicy z obszaru wskazuje jej blok, więc nie trzeba go szukać
+  // wśród bloków obszarów.
+  struct PolyArenaChunk *chunk = header->chunk;
+  size_t bytes = ArenaRound(count * sizeof(Mono));
+  // Ostatni przydział w bloku można zmienić w miejscu.
+  if (ArenaIsLast(chunk, header) && target_arena != NULL &&
+      chunk == target_arena->chunks &&
+      chunk->size - chunk->last >= sizeof(MonosHeader) + bytes) {
+    header->size = bytes;
+    chunk->used = chunk->last + sizeof(MonosHeader) + bytes;
+    return arr;
+  }
+
+  Mono *res = PolyMonosAlloc(count);
+  size_t copy = header->size < count * sizeof(Mono) ?
+                header->size : count * sizeof(Mono);
+  memcpy(res, arr, copy);
+  PolyMonosFree(arr);
+  return res;
+}
+
+void PolyMonosFree(Mono *arr) {
+  if (arr == NULL)
+    return;
+
+  MonosHeader *header = MonosHeaderOf(arr);
+  if (!header->is_in_arena) {
+    HeapFree(arr);
+    return;
+  }
+
+  // Zwolnienie ostatniego przydziału cofa wskaźnik bloku, a pozostałe
+  // tablice są zwalniane wraz z obszarem.
+  struct PolyArenaChunk *chunk = header->chunk;
+  if (ArenaIsLast(chunk, header)) {
+    chunk->used = chunk->last;
+    chunk->last = ARENA_NO_LAST;
+  }
+}
+
+Poly PolyFromMonos(size_t count, Mono *arr) {
+  assert(count > 0);
+  if (count == 1 && PolyIsCoeff(&(arr[0].p))) {
+    Mono mono = arr[0];
+    PolyMonosFree(arr);
+    return mono.exp == 0 ? mono.p : PolyInline(mono.p.coeff, mono.exp);
+  }
+  Poly p = {.size = count, .arr = arr};
+  return PolyIntern(&p);
+}
+
+/**
+ * Daje nagłówek, w którym są liczone odwołania do tablicy jednomianów.
+ * @param[in] arr : tablica jednomianów
+ * @return nagłówek bloku tablicy albo nagłówek tablicy
+ */
+static inline MonosHeader *MonosOwnerOf(const Mono *arr) {
+  MonosHeader *header = MonosHeaderOf(arr);
+  MonosHeader *block = MonosBlockOf(header);
+  return block != NULL ? block : header;
+}
+
+void PolyMonosRetain(Mono *arr) {
+  atomic_fetch_add_explicit(&(MonosOwnerOf(arr)->refs), 1,
+                            memory_order_relaxed);
+}
+
+bool PolyMonosRelease(Mono *arr) {
+  MonosHeader *block = MonosBlockOf(MonosHeaderOf(arr));
+  atomic_size_t *refs = &(MonosOwnerOf(arr)->refs);
+  // Jedyne odwołanie nie może zostać w tym czasie skopiowane przez inny
+  // wątek, więc nie trzeba go zmniejszać niepodzielnie.
+  bool is_last =
+    atomic_load_explicit(refs, memory_order_acquire) == 1 ||
+    atomic_fetch_sub_explicit(refs, 1, memory_order_acq_rel) == 1;
+  // Jednomiany bloku nie mają odwołań spoza niego, więc wystarczy go zwolnić.
+  if (is_last && block != NULL) {
+    AllocatorFree(block);
+    return false;
+  }
+  return is_last;
+}
+
+bool PolyMonosIsShared(const Mono *arr) {
+  return MonosBlockOf(MonosHeaderOf(arr)) != NULL ||
+         PolyMonosIsInterned(arr) ||
+         atomic_load_explicit(&(MonosHeaderOf(arr)->refs),
+                              memory_order_acquire) > 1;
+}
+
+/**
+ * Liczy bajty potrzebne na poziomy wielomianu w bloku kopii.
+ * @param[in] p : wielomian
+ * @return liczba bajtów
+ */
+static size_t ContiguousSize(const Poly *p) {
+  if (PolyIsCoeff(p) || PolyIsInline(p))
+    return 0;
+
+  size_t bytes = sizeof(MonosHeader) + ArenaRound(p->size * sizeof(Mono));
+  for (size_t i = 0; i < p->size; i++)
+    bytes += ContiguousSize(&(p->arr[i].p));
+  return bytes;
+}
+
+/**
+ * Kopiuje poziomy wielomianu do bloku, zaczynając od adresu @p *next,
+ * w kolejności przeszukiwania w głąb.
+ * @param[in] p : wielomian
+ * @param[in] block : nagłówek bloku
+ * @param[in,out] next : pierwszy wolny bajt bloku
+ * @return kopia wielomianu
+ */
+static Poly ContiguousCopy(const Poly *p, MonosHeader *block, char **next) {
+  if (PolyIsCoeff(p) || PolyIsInline(p))
+    return *p;
+
+  MonosHeader *header = (MonosHeader *)*next;
+  *next += sizeof(MonosHeader) + ArenaRound(p->size * sizeof(Mono));
+  atomic_init(&(header->refs), 0);
+  atomic_init(&(header->is_interned), false);
+  header->is_in_arena = false;
+  header->block = block;
+  Mono *arr = (Mono *)(header + 1);
+  for (size_t i = 0; i < p->size; i++)
+    arr[i] = (Mono) {.p = ContiguousCopy(&(p->arr[i].p), block, next),
+                     .exp = p->arr[i].exp};
+  return (Poly) {.size = p->size, .arr = arr};
+}
+
+Poly PolyCloneContiguous(const Poly *p) {
+  size_t bytes = ContiguousSize(p);
+  if (bytes == 0)
+    return *p;
+
+  MonosHeader *block =
+    (MonosHeader *)AllocatorMalloc(sizeof(MonosHeader) + bytes);
+  block->size = sizeof(MonosHeader) + bytes;
+  atomic_init(&(block->refs), 1);
+  atomic_init(&(block->is_interned), false);
+  block->is_in_arena = false;
+  block->block = NULL;
+  char *next = (char *)(block + 1);
+  return ContiguousCopy(p, block, &next);
+}
+
+void PolyMonosSetInterned(Mono *arr) {
+  atomic_store_explicit(&(MonosHeaderOf(arr)->is_interned), true,
+                        memory_order_release);
+}
+
+bool PolyMonosIsInterned(const Mono *arr) {
+  return atomic_load_explicit(&(MonosHeaderOf(arr)->is_interned),
+                              memory_order_acquire);
+}
+
+bool PolyMonosIsInArena(const Mono *arr) {
+  return MonosHeaderOf(arr)->is_in_arena;
+}
+
+void PolyArenaBegin(PolyArena *arena, bool use_huge_pages) {
+  *arena = (PolyArena) {.chunks = NULL,
+                        .next_chunk_size = ARENA_MIN_CHUNK_SIZE,
+                        .use_huge_pages = use_huge_pages,
+                        .prev = current_arena, .prev_target = target_arena};
+  current_arena = arena;
+  target_arena = arena;
+}
+
+/**
+ * Kopiuje poza obszar te poziomy wielomianu, które korzystają z pamięci
+ * obszaru, same lub przez swoje jednomiany. Pozostałe poziomy są
+ * współdzielone z kopią.
+ * @param[in] arena : obszar
+ * @param[in] p : wielomian
+ * @param[out] copy : kopia wielomianu, jeśli była potrzebna
+ * @return czy @p p korzysta z pamięci obszaru?
+ */
+static bool ArenaExport(const PolyArena *arena, const Poly *p, Poly *copy) {
+  if (PolyIsCoeff(p) || PolyIsInline(p))
+    return false;
+
+  const MonosHeader *header = MonosHeaderOf(p->arr);
+  Mono *arr = header->is_in_arena && header->chunk->arena == arena ?
+              PolyMonosAlloc(p->size) : NULL;
+  for (size_t i = 0; i < p->size; i++) {
+    Poly child;
+    if (ArenaExport(arena, &(p->arr[i].p), &child)) {
+      if (arr == NULL) {
+        arr = PolyMonosAlloc(p->size);
+        for (size_t j = 0; j < i; j++)
+          arr[j] = MonoClone(&(p->arr[j]));
+      }
+      arr[i] = MonoFromPoly(&child, p->arr[i].exp);
+    }
+    else if (arr != NULL) {
+      arr[i] = MonoClone(&(p->arr[i]));
+    }
+  }
+
+  if (arr == NULL)
+    return false;
+  Poly res = {.size = p->size, .arr = arr};
+  *copy = PolyIntern(&res);
+  return true;
+}
+
+Poly PolyArenaEnd(PolyArena *arena, Poly *result) {
+  assert(current_arena == arena);
+
+  // Poziomy wyniku spoza obszaru, na przykład wyniki innych wątków albo
+  // współdzielone poziomy argumentów, nie są kopiowane. Oryginał jest
+  // usuwany, aby zwolnić odwołania do nich.
+  target_arena = arena->prev_target;
+  Poly copy;
+  if (!ArenaExport(arena, result, &copy))
+    copy = PolyClone(result);
+  PolyDestroy(result);
+
+  current_arena = arena->prev;
+  struct PolyArenaChunk *chunk = arena->chunks;
+  while (chunk != NULL) {
+    struct PolyArenaChunk *next = chunk->next;
+#if ARENA_HUGE_PAGES_ENABLED
+    if (chunk->is_mapped)
+      munmap(chunk, offsetof(struct PolyArenaChunk, data) + chunk->size);
+    else
+      AllocatorFree(chunk);
+#else
+    AllocatorFree(chunk);
+#endif
+    chunk = next;
+  }
+  arena->chunks = NULL;
+  return copy;
+}
+
+PolyArena *PolyArenaSuspend(void) {
+  PolyArena *arena = target_arena;
+  target_arena = NULL;
+  return arena;
+}
+
+void PolyArenaResume(PolyArena *arena) {
+  target_arena = arena;
+}
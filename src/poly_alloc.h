@@ -0,0 +1,241 @@
+/** @file
+  Moduł przydzielający pamięć na tablice jednomianów wielomianów
+
+  Wszystkie tablice jednomianów tworzone przez bibliotekę są przydzielane
+  i zwalniane przez funkcje tego modułu. Domyślnie korzystają one z malloc,
+  realloc i free. Operacja tworząca wiele tymczasowych wielomianów może
+  jednak rozpocząć w bieżącym wątku obszar (ang. arena), z którego pamięć
+  jest przydzielana przez przesuwanie wskaźnika, a zwalniana jednorazowo
+  przy kończeniu obszaru. Z obszaru wychodzi jedynie kopia wyniku operacji.
+
+  Pamięć modułu pochodzi z alokatora ustawianego funkcją PolySetAllocator,
+  dzięki czemu można ją kierować do dowolnej biblioteki przydzielającej
+  pamięć, własnego obszaru albo alokatora zliczającego przydziały.
+
+  Każda tablica ma licznik odwołań, dzięki czemu kopia wielomianu może
+  współdzielić tablice z oryginałem. Współdzielona tablica nie jest
+  modyfikowana, a operacje przejmujące wielomian na własność kopiują ją przed
+  zmianą.
+
+  Jeśli zdefiniowano POLY_POOL (opcja CMake o tej samej nazwie), małe tablice
+  poza obszarami są przydzielane z puli bloków o kilku klasach rozmiarów.
+  Każdy wątek ma własną pamięć podręczną wolnych bloków, uzupełnianą paczkami
+  z puli wspólnej, więc większość przydziałów nie wymaga synchronizacji.
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef POLYNOMIALS_POLY_ALLOC_H
+#define POLYNOMIALS_POLY_ALLOC_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "poly.h"
+
+/** To jest struktura przechowująca jeden blok pamięci obszaru. */
+struct PolyArenaChunk;
+
+/**
+ * To jest struktura przechowująca obszar, z którego przydzielane są tablice
+ * jednomianów.
+ */
+typedef struct PolyArena {
+  struct PolyArenaChunk *chunks; ///< bloki pamięci, od najnowszego
+  size_t next_chunk_size; ///< rozmiar następnego bloku w bajtach
+  bool use_huge_pages; ///< czy duże bloki mają korzystać z dużych stron?
+  struct PolyArena *prev; ///< obszar aktywny przed rozpoczęciem tego obszaru
+  /** obszar, z którego przydzielano pamięć przed rozpoczęciem tego obszaru */
+  struct PolyArena *prev_target;
+} PolyArena;
+
+/**
+ * To jest struktura przechowująca statystyki przydziałów tablic jednomianów
+ * poza obszarami.
+ */
+typedef struct PolyAllocStats {
+  size_t pool_allocs; ///< liczba przydziałów z puli
+  /** liczba przydziałów z puli, przy których pamięć podręczna wątku była
+   * pusta */
+  size_t pool_refills;
+  size_t pool_slabs; ///< liczba fragmentów pamięci przydzielonych dla puli
+  size_t large_allocs; ///< liczba przydziałów zbyt dużych dla puli
+} PolyAllocStats;
+
+/**
+ * To jest struktura przechowująca funkcje, którymi biblioteka przydziela
+ * i zwalnia pamięć na wielomiany. Każda z nich otrzymuje jako pierwszy
+ * argument kontekst podany przez użytkownika.
+ */
+typedef struct PolyAllocator {
+  /** przydziela @p size bajtów; zwraca NULL, jeśli się nie uda */
+  void *(*malloc_fn)(void *context, size_t size);
+  /** zmienia rozmiar pamięci @p ptr; zwraca NULL, jeśli się nie uda */
+  void *(*realloc_fn)(void *context, void *ptr, size_t size);
+  void (*free_fn)(void *context, void *ptr); ///< zwalnia pamięć @p ptr
+  void *context; ///< kontekst przekazywany funkcjom alokatora
+} PolyAllocator;
+
+/**
+ * Ustawia alokator, z którego pochodzą tablice jednomianów, bloki obszarów
+ * i pamięć puli. Jeśli alokator zwróci NULL, program kończy się kodem 1.
+ * Funkcję należy wywołać, gdy nie istnieje żaden wielomian ani obszar
+ * i żaden inny wątek nie korzysta z biblioteki; przy włączonej puli także
+ * przed pierwszym przydziałem. Zmiana alokatora, gdy istnieją wielomiany,
+ * jest niedozwolona: ich tablice zostałyby zwolnione lub powiększone przez
+ * alokator, który ich nie przydzielił.
+ * @param[in] allocator : alokator albo NULL, aby przywrócić domyślny,
+ * korzystający z malloc, realloc i free
+ */
+void PolySetAllocator(const PolyAllocator *allocator);
+
+/**
+ * Podaje bieżący alokator.
+ * @return alokator
+ */
+PolyAllocator PolyGetAllocator(void);
+
+/**
+ * Tworzy wielomian @f$cx_i^e@f$ przechowywany bez tablicy jednomianów.
+ * @param[in] coeff : niezerowy współczynnik @f$c@f$
+ * @param[in] exp : dodatni wykładnik @f$e@f$
+ * @return wielomian @f$cx_i^e@f$
+ */
+static inline Poly PolyInline(poly_coeff_t coeff, poly_exp_t exp) {
+  // Wykładnik jest nieujemny, więc po przesunięciu o jeden bit mieści się
+  // w uintptr_t także na platformach 32-bitowych.
+  _Static_assert(UINTPTR_MAX >> 1 >= INT_MAX,
+                 "uintptr_t cannot hold a tagged exponent");
+  assert(coeff != 0 && exp > 0);
+  return (Poly) {.coeff = coeff,
+                 .arr = (Mono *)(((uintptr_t)exp << 1) | 1)};
+}
+
+/**
+ * Tworzy wielomian z niepustej tablicy jednomianów posortowanych ściśle
+ * rosnąco po wykładnikach i mających niezerowe współczynniki, sprowadzając go
+ * do jednoznacznej postaci. Jednomian @f$cx_i^0@f$ staje się współczynnikiem,
+ * a jednomian @f$cx_i^e@f$ jest przechowywany bez tablicy. Pozostałe
+ * wielomiany trafiają do tablicy unikatowej.
+ * Przejmuje na własność tablicę @p arr i jej zawartość.
+ * @param[in] count : liczba jednomianów
+ * @param[in] arr : tablica przydzielona przez PolyMonosAlloc
+ * @return wielomian w jednoznacznej, uporządkowanej postaci
+ */
+Poly PolyFromMonos(size_t count, Mono *arr);
+
+/**
+ * Przydziela tablicę na @p count jednomianów z jednym odwołaniem.
+ * @param[in] count : dodatnia liczba jednomianów
+ * @return tablica jednomianów
+ */
+Mono *PolyMonosAlloc(size_t count);
+
+/**
+ * Zmienia rozmiar niewspółdzielonej tablicy jednomianów, zachowując jej
+ * początkowe elementy.
+ * @param[in] arr : tablica przydzielona przez PolyMonosAlloc albo NULL
+ * @param[in] count : dodatnia liczba jednomianów
+ * @return tablica jednomianów, być może pod innym adresem
+ */
+Mono *PolyMonosRealloc(Mono *arr, size_t count);
+
+/**
+ * Zwalnia tablicę jednomianów, nie usuwając jej jednomianów. Tablica
+ * przydzielona z obszaru jest zwalniana dopiero wraz z całym obszarem.
+ * @param[in] arr : niewspółdzielona tablica przydzielona przez PolyMonosAlloc
+ * albo NULL
+ */
+void PolyMonosFree(Mono *arr);
+
+/**
+ * Dodaje odwołanie do tablicy jednomianów. Tablica, do której jest więcej niż
+ * jedno odwołanie, jest współdzielona i nie wolno jej modyfikować.
+ * @param[in] arr : tablica przydzielona przez PolyMonosAlloc
+ */
+void PolyMonosRetain(Mono *arr);
+
+/**
+ * Usuwa odwołanie do tablicy jednomianów. Ostatnie odwołanie do tablic
+ * bloku kopii z PolyCloneContiguous zwalnia cały blok.
+ * @param[in] arr : tablica przydzielona przez PolyMonosAlloc albo z bloku
+ * kopii
+ * @return czy było to ostatnie odwołanie do tablicy spoza bloku? Wtedy
+ * wywołujący usuwa jednomiany tablicy i zwalnia ją przez PolyMonosFree.
+ */
+bool PolyMonosRelease(Mono *arr);
+
+/**
+ * Sprawdza, czy tablica jednomianów jest współdzielona.
+ * @param[in] arr : tablica przydzielona przez PolyMonosAlloc
+ * @return czy do tablicy jest więcej niż jedno odwołanie albo jest ona
+ * w tablicy unikatowej lub w bloku kopii?
+ */
+bool PolyMonosIsShared(const Mono *arr);
+
+/**
+ * Oznacza tablicę jednomianów jako umieszczoną w tablicy unikatowej modułu
+ * poly_intern. Od tej chwili tablica jest traktowana jak współdzielona.
+ * @param[in] arr : tablica przydzielona przez PolyMonosAlloc
+ */
+void PolyMonosSetInterned(Mono *arr);
+
+/**
+ * Sprawdza, czy tablica jednomianów jest w tablicy unikatowej.
+ * @param[in] arr : tablica przydzielona przez PolyMonosAlloc
+ * @return czy tablica jest w tablicy unikatowej?
+ */
+bool PolyMonosIsInterned(const Mono *arr);
+
+/**
+ * Sprawdza, czy tablica jednomianów pochodzi z obszaru. Pochodzenie tablicy
+ * jest zapisane w jej nagłówku, więc sprawdzenie działa w czasie stałym.
+ * @param[in] arr : tablica przydzielona przez PolyMonosAlloc
+ * @return czy tablica pochodzi z obszaru?
+ */
+bool PolyMonosIsInArena(const Mono *arr);
+
+/**
+ * Rozpoczyna obszar w bieżącym wątku. Do zakończenia obszaru tablice
+ * jednomianów przydzielane w tym wątku pochodzą z obszaru. Obszary mogą być
+ * zagnieżdżone.
+ * @param[out] arena : obszar
+ * @param[in] use_huge_pages : czy duże bloki obszaru mają korzystać
+ * z przezroczystych dużych stron, jeśli system je udostępnia?
+ */
+void PolyArenaBegin(PolyArena *arena, bool use_huge_pages);
+
+/**
+ * Kończy obszar rozpoczęty ostatnio w bieżącym wątku i zwalnia całą jego
+ * pamięć. Przejmuje na własność wielomian @p result, który może korzystać
+ * z pamięci obszaru, i zwraca jego kopię spoza obszaru.
+ * @param[in] arena : obszar
+ * @param[in] result : wynik operacji
+ * @return kopia wyniku operacji
+ */
+Poly PolyArenaEnd(PolyArena *arena, Poly *result);
+
+/**
+ * Zawiesza obszar aktywny w bieżącym wątku, tak aby kolejne tablice były
+ * przydzielane poza nim, na przykład gdy mają przeżyć operację.
+ * @return zawieszony obszar albo NULL, jeśli żaden nie był aktywny
+ */
+PolyArena *PolyArenaSuspend(void);
+
+/**
+ * Wznawia obszar zawieszony przez PolyArenaSuspend.
+ * @param[in] arena : obszar zwrócony przez PolyArenaSuspend
+ */
+void PolyArenaResume(PolyArena *arena);
+
+/**
+ * Podaje statystyki przydziałów wykonanych przez bieżący wątek i przez
+ * zakończone wątki. Jeśli nie zdefiniowano POLY_POOL, wszystkie statystyki
+ * są zerowe.
+ * @return statystyki przydziałów
+ */
+PolyAllocStats PolyAllocGetStats(void);
+
+#endif //POLYNOMIALS_POLY_ALLOC_H
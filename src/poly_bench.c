@@ -0,0 +1,600 @@
+/** @file
+  Program porównujący szybkość algorytmów mnożenia i wyliczania wartości
+  wielomianów
+
+  Dla rosnących długości gęstych wielomianów jednej zmiennej mierzy czas
+  mnożenia algorytmem szkolnym, algorytmem Karatsuby, szybką transformatą
+  teoretyczno-liczbową oraz funkcją PolyMul, a następnie wypisuje długości,
+  od których szybsze algorytmy zaczynają się opłacać. Następnie mierzy, ile
+  punktów na sekundę są w stanie obsłużyć różne sposoby wyliczania wartości
+  wielomianu, porównuje czas dodawania wielomianów w reprezentacji
+  rekurencyjnej i w postaci rozwiniętej, mierzy operacje przydzielające wiele
+  małych tablic jednomianów, a na końcu porównuje przeglądanie wielomianu
+  i jego kopii z PolyCloneContiguous. Porównanie puli z malloc wymaga dwóch
+  kompilacji, z opcją POLY_POOL i bez niej.
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "poly.h"
+#include "poly_alloc.h"
+#include "poly_dist.h"
+#include "poly_mul.h"
+#include "poly_jit.h"
+#include "poly_program.h"
+#include "safe_functions.h"
+
+/** Minimalny łączny czas pojedynczego pomiaru w sekundach. */
+#define MIN_MEASURE_TIME 0.05
+
+/** Największa długość, dla której mierzony jest algorytm szkolny. */
+#define MAX_SCHOOLBOOK_LEN 8192
+
+/** Największa mierzona długość czynników. */
+#define MAX_LEN 65536
+
+/** Liczba zmiennych wielomianu, którego wartości są wyliczane. */
+#define EVAL_VARS 3
+
+/** Liczba punktów, w których są wyliczane wartości wielomianu. */
+#define EVAL_POINTS 4096
+
+/** Liczba zmiennych dodawanych wielomianów. */
+#define ADD_VARS 3
+
+/** Liczba zmiennych wielomianów w pomiarach przydziałów pamięci. */
+#define ALLOC_VARS 4
+
+/** Ograniczenie wykładników wielomianu kopiowanego do jednego bloku. */
+#define CONTIGUOUS_MAX_EXP 64
+
+/** To jest typ funkcji mnożącej gęste wielomiany jednej zmiennej. */
+typedef void (*dense_mul_t)(const poly_coeff_t a[], size_t n,
+                            const poly_coeff_t b[], size_t m,
+                            poly_coeff_t res[]);
+
+/**
+ * To jest typ funkcji wyliczającej wartości wielomianu w wielu punktach.
+ * Wielomian jest przekazywany w postaci odpowiedniej dla danej funkcji.
+ */
+typedef void (*eval_t)(void *evaluator, size_t k, size_t n,
+                       const poly_coeff_t points[], poly_coeff_t out[]);
+
+/**
+ * Opakowuje DenseMulNtt tak, aby miała typ dense_mul_t.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @param[out] res : tablica na @f$n + m - 1@f$ współczynników iloczynu
+ */
+static void DenseMulNttOrExit(const poly_coeff_t a[], size_t n,
+                              const poly_coeff_t b[], size_t m,
+                              poly_coeff_t res[]) {
+  if (!DenseMulNtt(a, n, b, m, res)) {
+    fprintf(stderr, "NTT is not available on this platform\n");
+    exit(1);
+  }
+}
+
+/**
+ * Losuje tablicę współczynników o wartościach bezwzględnych mniejszych od
+ * @f$2^{bits - 1}@f$. Dla @p bits równego 64 losuje współczynniki z pełnego
+ * zakresu typu poly_coeff_t.
+ * @param[in] n : liczba współczynników
+ * @param[in] bits : liczba bitów współczynników wraz ze znakiem
+ * @return zaalokowana tablica współczynników
+ */
+static poly_coeff_t *RandomCoeffs(size_t n, int bits) {
+  poly_coeff_t *arr = (poly_coeff_t *)safeMalloc(n * sizeof(poly_coeff_t));
+  for (size_t i = 0; i < n; i++) {
+    unsigned long value = 0;
+    for (int j = 0; j < 4; j++)
+      value = (value << 16) ^ (unsigned long)(rand() & 0xffff);
+    arr[i] = bits >= 64 ? (poly_coeff_t)value :
+             (poly_coeff_t)(value >> (65 - bits)) *
+             (value % 2 == 0 ? 1 : -1);
+  }
+  return arr;
+}
+
+/**
+ * Tworzy wielomian jednej zmiennej z tablicy współczynników.
+ * @param[in] a : współczynniki przy kolejnych potęgach zmiennej
+ * @param[in] n : liczba współczynników
+ * @return wielomian
+ */
+static Poly DenseToPoly(const poly_coeff_t a[], size_t n) {
+  Mono *monos = (Mono *)safeMalloc(n * sizeof(Mono));
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (a[i] != 0) {
+      Poly coeff = PolyFromCoeff(a[i]);
+      monos[count++] = MonoFromPoly(&coeff, (poly_exp_t)i);
+    }
+  }
+  return PolyOwnMonos(count, monos);
+}
+
+/**
+ * Sprawdza, czy wielomian jednej zmiennej ma podane współczynniki.
+ * @param[in] p : wielomian
+ * @param[in] a : współczynniki przy kolejnych potęgach zmiennej
+ * @param[in] n : liczba współczynników
+ * @return czy wielomian ma podane współczynniki?
+ */
+static bool PolyEqualsDense(const Poly *p, const poly_coeff_t a[], size_t n) {
+  Poly expected = DenseToPoly(a, n);
+  bool is_eq = PolyIsEq(p, &expected);
+  PolyDestroy(&expected);
+  return is_eq;
+}
+
+/**
+ * Mierzy średni czas mnożenia gęstych wielomianów podaną funkcją.
+ * @param[in] mul : funkcja mnożąca
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] n : liczba współczynników każdego z czynników
+ * @param[out] res : tablica na @f$2n - 1@f$ współczynników iloczynu
+ * @return czas jednego mnożenia w sekundach
+ */
+static double TimeDenseMul(dense_mul_t mul, const poly_coeff_t a[],
+                           const poly_coeff_t b[], size_t n,
+                           poly_coeff_t res[]) {
+  size_t repeats = 0;
+  clock_t begin = clock();
+  double elapsed;
+  do {
+    mul(a, n, b, n, res);
+    repeats++;
+    elapsed = (double)(clock() - begin) / CLOCKS_PER_SEC;
+  } while (elapsed < MIN_MEASURE_TIME);
+  return elapsed / repeats;
+}
+
+/**
+ * Mierzy średni czas mnożenia wielomianów funkcją PolyMul.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] prod : iloczyn z ostatniego mnożenia
+ * @return czas jednego mnożenia w sekundach
+ */
+static double TimePolyMul(const Poly *p, const Poly *q, Poly *prod) {
+  size_t repeats = 0;
+  clock_t begin = clock();
+  double elapsed;
+  *prod = PolyZero();
+  do {
+    PolyDestroy(prod);
+    *prod = PolyMul(p, q);
+    repeats++;
+    elapsed = (double)(clock() - begin) / CLOCKS_PER_SEC;
+  } while (elapsed < MIN_MEASURE_TIME);
+  return elapsed / repeats;
+}
+
+/**
+ * Porównuje algorytmy mnożenia dla rosnących długości czynników i wypisuje
+ * tabelę czasów oraz długości, od których szybsze algorytmy się opłacają.
+ * @param[in] bits : liczba bitów współczynników czynników wraz ze znakiem
+ * @return czy wszystkie algorytmy dały ten sam wynik?
+ */
+static bool BenchSeries(int bits) {
+  bool ok = true;
+  size_t karatsuba_crossover = 0, ntt_crossover = 0;
+
+  printf("Coefficients of %d bits\n", bits);
+  printf("%8s %14s %14s %14s %14s\n",
+         "len", "schoolbook[s]", "karatsuba[s]", "ntt[s]", "PolyMul[s]");
+  for (size_t n = 16; n <= MAX_LEN; n *= 2) {
+    poly_coeff_t *a = RandomCoeffs(n, bits);
+    poly_coeff_t *b = RandomCoeffs(n, bits);
+    poly_coeff_t *expected =
+      (poly_coeff_t *)safeMalloc((2 * n - 1) * sizeof(poly_coeff_t));
+    poly_coeff_t *res =
+      (poly_coeff_t *)safeMalloc((2 * n - 1) * sizeof(poly_coeff_t));
+
+    double karatsuba = TimeDenseMul(DenseMulKaratsuba, a, b, n, expected);
+    double ntt = TimeDenseMul(DenseMulNttOrExit, a, b, n, res);
+    ok &= memcmp(expected, res, (2 * n - 1) * sizeof(poly_coeff_t)) == 0;
+
+    double schoolbook = -1;
+    if (n <= MAX_SCHOOLBOOK_LEN) {
+      schoolbook = TimeDenseMul(DenseMulSchoolbook, a, b, n, res);
+      ok &= memcmp(expected, res, (2 * n - 1) * sizeof(poly_coeff_t)) == 0;
+    }
+
+    Poly p = DenseToPoly(a, n), q = DenseToPoly(b, n), prod;
+    double poly_mul = TimePolyMul(&p, &q, &prod);
+    ok &= PolyEqualsDense(&prod, expected, 2 * n - 1);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&prod);
+
+    if (schoolbook >= 0)
+      printf("%8zu %14.6f %14.6f %14.6f %14.6f\n",
+             n, schoolbook, karatsuba, ntt, poly_mul);
+    else
+      printf("%8zu %14s %14.6f %14.6f %14.6f\n",
+             n, "-", karatsuba, ntt, poly_mul);
+
+    if (karatsuba_crossover == 0 && schoolbook >= 0 && karatsuba < schoolbook)
+      karatsuba_crossover = n;
+    if (ntt_crossover == 0 && ntt < karatsuba)
+      ntt_crossover = n;
+
+    free(a);
+    free(b);
+    free(expected);
+    free(res);
+  }
+
+  printf("Karatsuba beats schoolbook from len %zu\n", karatsuba_crossover);
+  printf("NTT beats Karatsuba from len %zu\n\n", ntt_crossover);
+  return ok;
+}
+
+/**
+ * Wylicza wartości wielomianu w kolejnych punktach funkcją PolyEval.
+ * @param[in] evaluator : wskaźnik na wielomian
+ * @param[in] k : liczba współrzędnych każdego punktu
+ * @param[in] n : liczba punktów
+ * @param[in] points : współrzędne kolejnych punktów
+ * @param[out] out : tablica na @p n wartości wielomianu
+ */
+static void EvalPointByPoint(void *evaluator, size_t k, size_t n,
+                             const poly_coeff_t points[], poly_coeff_t out[]) {
+  const Poly *p = (const Poly *)evaluator;
+  for (size_t j = 0; j < n; j++)
+    out[j] = PolyEval(p, k, points + j * k);
+}
+
+/**
+ * Wylicza wartości wielomianu w kolejnych punktach funkcją PolyEvalBatch.
+ * @param[in] evaluator : wskaźnik na wielomian
+ * @param[in] k : liczba współrzędnych każdego punktu
+ * @param[in] n : liczba punktów
+ * @param[in] points : współrzędne kolejnych punktów
+ * @param[out] out : tablica na @p n wartości wielomianu
+ */
+static void EvalBatch(void *evaluator, size_t k, size_t n,
+                      const poly_coeff_t points[], poly_coeff_t out[]) {
+  PolyEvalBatch((const Poly *)evaluator, k, n, points, out);
+}
+
+/**
+ * Wylicza wartości skompilowanego wielomianu w kolejnych punktach.
+ * @param[in] evaluator : wskaźnik na skompilowany wielomian
+ * @param[in] k : liczba współrzędnych każdego punktu
+ * @param[in] n : liczba punktów
+ * @param[in] points : współrzędne kolejnych punktów
+ * @param[out] out : tablica na @p n wartości wielomianu
+ */
+static void EvalProgram(void *evaluator, size_t k, size_t n,
+                        const poly_coeff_t points[], poly_coeff_t out[]) {
+  PolyProgram *program = (PolyProgram *)evaluator;
+  for (size_t j = 0; j < n; j++)
+    out[j] = PolyProgramEval(program, k, points + j * k);
+}
+
+/**
+ * Wylicza wartości wielomianu przetłumaczonego na kod maszynowy w kolejnych
+ * punktach.
+ * @param[in] evaluator : wskaźnik na przetłumaczony wielomian
+ * @param[in] k : liczba współrzędnych każdego punktu
+ * @param[in] n : liczba punktów
+ * @param[in] points : współrzędne kolejnych punktów
+ * @param[out] out : tablica na @p n wartości wielomianu
+ */
+static void EvalJit(void *evaluator, size_t k, size_t n,
+                    const poly_coeff_t points[], poly_coeff_t out[]) {
+  PolyJit *jit = (PolyJit *)evaluator;
+  for (size_t j = 0; j < n; j++)
+    out[j] = PolyJitEval(jit, k, points + j * k);
+}
+
+/**
+ * Losuje wielomian o @p terms jednomianach zmiennych
+ * @f$x_0, \ldots, x_{k-1}@f$ o wykładnikach mniejszych od @p max_exp.
+ * @param[in] k : liczba zmiennych
+ * @param[in] terms : liczba losowanych jednomianów
+ * @param[in] max_exp : ograniczenie wykładników
+ * @return wielomian
+ */
+static Poly RandomPoly(size_t k, size_t terms, poly_exp_t max_exp) {
+  Poly p = PolyZero();
+  for (size_t t = 0; t < terms; t++) {
+    Poly term = PolyFromCoeff(rand() % 201 - 100);
+    for (size_t i = k; i-- > 0;) {
+      Mono *mono = (Mono *)safeMalloc(sizeof(Mono));
+      mono[0] = (Mono) {.p = term, .exp = rand() % max_exp};
+      term = PolyOwnMonos(1, mono);
+    }
+    p = PolyAddOwn(&p, &term);
+  }
+  return p;
+}
+
+/**
+ * Mierzy, ile punktów na sekundę obsługuje funkcja wyliczająca wartości.
+ * @param[in] eval : funkcja wyliczająca wartości
+ * @param[in] evaluator : wielomian w postaci odpowiedniej dla @p eval
+ * @param[in] points : współrzędne EVAL_POINTS punktów
+ * @param[out] out : tablica na EVAL_POINTS wartości
+ * @return liczba punktów na sekundę
+ */
+static double TimeEval(eval_t eval, void *evaluator,
+                       const poly_coeff_t points[], poly_coeff_t out[]) {
+  size_t repeats = 0;
+  clock_t begin = clock();
+  double elapsed;
+  do {
+    eval(evaluator, EVAL_VARS, EVAL_POINTS, points, out);
+    repeats++;
+    elapsed = (double)(clock() - begin) / CLOCKS_PER_SEC;
+  } while (elapsed < MIN_MEASURE_TIME);
+  return (double)repeats * EVAL_POINTS / elapsed;
+}
+
+/**
+ * Porównuje sposoby wyliczania wartości wielomianów o rosnącej liczbie
+ * jednomianów i wypisuje tabelę liczby obsłużonych punktów na sekundę.
+ * @return czy wszystkie sposoby dały te same wartości?
+ */
+static bool BenchEval(void) {
+  bool ok = true;
+  poly_coeff_t *points = RandomCoeffs(EVAL_VARS * EVAL_POINTS, 64);
+  poly_coeff_t *expected =
+    (poly_coeff_t *)safeMalloc(EVAL_POINTS * sizeof(poly_coeff_t));
+  poly_coeff_t *out =
+    (poly_coeff_t *)safeMalloc(EVAL_POINTS * sizeof(poly_coeff_t));
+
+  printf("Evaluation of a polynomial of %d variables\n", EVAL_VARS);
+  Poly one = PolyFromCoeff(1);
+  PolyJit probe = PolyJitNew(&one);
+  if (!PolyJitIsNative(&probe))
+    printf("JIT is not available, jit column uses the interpreter\n");
+  PolyJitDestroy(&probe);
+  printf("%8s %16s %16s %16s %16s\n", "terms", "PolyEval[pt/s]",
+         "batch[pt/s]", "program[pt/s]", "jit[pt/s]");
+  for (size_t terms = 16; terms <= 4096; terms *= 4) {
+    Poly p = RandomPoly(EVAL_VARS, terms, 16);
+    PolyProgram program = PolyProgramNew(&p);
+    PolyJit jit = PolyJitNew(&p);
+    double tree = TimeEval(EvalPointByPoint, &p, points, expected);
+    double batch = TimeEval(EvalBatch, &p, points, out);
+    ok &= memcmp(expected, out, EVAL_POINTS * sizeof(poly_coeff_t)) == 0;
+    double compiled = TimeEval(EvalProgram, &program, points, out);
+    ok &= memcmp(expected, out, EVAL_POINTS * sizeof(poly_coeff_t)) == 0;
+    double native = TimeEval(EvalJit, &jit, points, out);
+    ok &= memcmp(expected, out, EVAL_POINTS * sizeof(poly_coeff_t)) == 0;
+    printf("%8zu %16.0f %16.0f %16.0f %16.0f\n",
+           terms, tree, batch, compiled, native);
+    PolyJitDestroy(&jit);
+    PolyProgramDestroy(&program);
+    PolyDestroy(&p);
+  }
+  printf("\n");
+
+  free(points);
+  free(expected);
+  free(out);
+  return ok;
+}
+
+/**
+ * Mierzy średni czas dodawania wielomianów w reprezentacji rekurencyjnej.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return liczba dodawań na sekundę
+ */
+static double TimePolyAdd(const Poly *p, const Poly *q) {
+  size_t repeats = 0;
+  clock_t begin = clock();
+  double elapsed;
+  do {
+    Poly sum = PolyAdd(p, q);
+    PolyDestroy(&sum);
+    repeats++;
+    elapsed = (double)(clock() - begin) / CLOCKS_PER_SEC;
+  } while (elapsed < MIN_MEASURE_TIME);
+  return (double)repeats / elapsed;
+}
+
+/**
+ * Mierzy średni czas dodawania wielomianów w postaci rozwiniętej.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return liczba dodawań na sekundę
+ */
+static double TimePolyDistAdd(const PolyDist *p, const PolyDist *q) {
+  size_t repeats = 0;
+  clock_t begin = clock();
+  double elapsed;
+  do {
+    PolyDist sum = PolyDistAdd(p, q);
+    PolyDistDestroy(&sum);
+    repeats++;
+    elapsed = (double)(clock() - begin) / CLOCKS_PER_SEC;
+  } while (elapsed < MIN_MEASURE_TIME);
+  return (double)repeats / elapsed;
+}
+
+/**
+ * Porównuje dodawanie wielomianów o rosnącej liczbie jednomianów
+ * w reprezentacji rekurencyjnej i w postaci rozwiniętej i wypisuje tabelę
+ * liczby dodawań na sekundę.
+ * @return czy obie reprezentacje dały tę samą sumę?
+ */
+static bool BenchAdd(void) {
+  bool ok = true;
+
+  printf("Addition of polynomials of %d variables\n", ADD_VARS);
+  printf("%8s %16s %16s\n", "terms", "PolyAdd[op/s]", "dist[op/s]");
+  for (size_t terms = 16; terms <= 4096; terms *= 4) {
+    Poly p = RandomPoly(ADD_VARS, terms, 16);
+    Poly q = RandomPoly(ADD_VARS, terms, 16);
+    PolyDist p_dist, q_dist;
+    ok &= PolyDistFromPoly(&p, PolyDistBits(&p), &p_dist);
+    ok &= PolyDistFromPoly(&q, p_dist.bits, &q_dist);
+    if (!ok) {
+      PolyDestroy(&p);
+      PolyDestroy(&q);
+      break;
+    }
+
+    double recursive = TimePolyAdd(&p, &q);
+    double distributed = TimePolyDistAdd(&p_dist, &q_dist);
+    printf("%8zu %16.0f %16.0f\n", terms, recursive, distributed);
+
+    Poly sum = PolyAdd(&p, &q);
+    PolyDist sum_dist = PolyDistAdd(&p_dist, &q_dist);
+    Poly sum_unpacked = PolyDistToPoly(&sum_dist);
+    ok &= PolyIsEq(&sum, &sum_unpacked);
+    PolyDestroy(&sum);
+    PolyDestroy(&sum_unpacked);
+    PolyDistDestroy(&sum_dist);
+    PolyDistDestroy(&p_dist);
+    PolyDistDestroy(&q_dist);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+  }
+  printf("\n");
+
+  return ok;
+}
+
+/**
+ * To jest typ wyliczeniowy opisujący operację mierzoną w BenchAlloc.
+ */
+typedef enum AllocOp {
+  ALLOC_CLONE, ///< PolyClone
+  ALLOC_ADD, ///< PolyAdd
+  ALLOC_MUL ///< PolyMul
+} AllocOp;
+
+/**
+ * Mierzy średni czas operacji na wielomianach wraz z usunięciem wyniku.
+ * @param[in] op : operacja
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return liczba operacji na sekundę
+ */
+static double TimeAllocOp(AllocOp op, const Poly *p, const Poly *q) {
+  size_t repeats = 0;
+  clock_t begin = clock();
+  double elapsed;
+  do {
+    Poly res;
+    switch (op) {
+      case ALLOC_CLONE:
+        res = PolyClone(p);
+        break;
+      case ALLOC_ADD:
+        res = PolyAdd(p, q);
+        break;
+      default:
+        res = PolyMul(p, q);
+        break;
+    }
+    PolyDestroy(&res);
+    repeats++;
+    elapsed = (double)(clock() - begin) / CLOCKS_PER_SEC;
+  } while (elapsed < MIN_MEASURE_TIME);
+  return (double)repeats / elapsed;
+}
+
+/**
+ * Mierzy operacje na wielomianach wielu zmiennych o małych wykładnikach,
+ * których poziomy mają po kilka jednomianów, i wypisuje tabelę liczby
+ * operacji na sekundę oraz statystyki przydziałów.
+ * @return true
+ */
+static bool BenchAlloc(void) {
+#ifdef POLY_POOL
+  printf("Small allocations of polynomials of %d variables (pool)\n",
+         ALLOC_VARS);
+#else
+  printf("Small allocations of polynomials of %d variables (malloc)\n",
+         ALLOC_VARS);
+#endif
+  printf("%8s %16s %16s %16s\n",
+         "terms", "PolyClone[op/s]", "PolyAdd[op/s]", "PolyMul[op/s]");
+  PolyAllocStats before = PolyAllocGetStats();
+  for (size_t terms = 16; terms <= 1024; terms *= 4) {
+    Poly p = RandomPoly(ALLOC_VARS, terms, 4);
+    Poly q = RandomPoly(ALLOC_VARS, terms, 4);
+    double clone = TimeAllocOp(ALLOC_CLONE, &p, &q);
+    double add = TimeAllocOp(ALLOC_ADD, &p, &q);
+    double mul = TimeAllocOp(ALLOC_MUL, &p, &q);
+    printf("%8zu %16.0f %16.0f %16.0f\n", terms, clone, add, mul);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+  }
+
+  PolyAllocStats after = PolyAllocGetStats();
+  size_t allocs = after.pool_allocs - before.pool_allocs;
+  size_t refills = after.pool_refills - before.pool_refills;
+  if (allocs > 0)
+    printf("pool hit rate %.2f%%, %zu slabs, %zu large arrays\n",
+           100.0 * (double)(allocs - refills) / (double)allocs,
+           after.pool_slabs - before.pool_slabs,
+           after.large_allocs - before.large_allocs);
+  printf("\n");
+  return true;
+}
+
+/**
+ * Porównuje wyliczanie wartości wielomianów o rosnącej liczbie jednomianów,
+ * zbudowanych przez wielokrotne dodawanie, i ich kopii z PolyCloneContiguous
+ * i wypisuje tabelę liczby obsłużonych punktów na sekundę.
+ * @return czy kopie dały te same wartości co oryginały?
+ */
+static bool BenchContiguous(void) {
+  bool ok = true;
+  poly_coeff_t *points = RandomCoeffs(EVAL_VARS * EVAL_POINTS, 64);
+  poly_coeff_t *expected =
+    (poly_coeff_t *)safeMalloc(EVAL_POINTS * sizeof(poly_coeff_t));
+  poly_coeff_t *out =
+    (poly_coeff_t *)safeMalloc(EVAL_POINTS * sizeof(poly_coeff_t));
+
+  printf("Evaluation of a polynomial and of its contiguous copy\n");
+  printf("%8s %16s %16s\n", "terms", "original[pt/s]", "contiguous[pt/s]");
+  for (size_t terms = 256; terms <= 65536; terms *= 4) {
+    Poly p = RandomPoly(EVAL_VARS, terms, CONTIGUOUS_MAX_EXP);
+    Poly copy = PolyCloneContiguous(&p);
+    double original = TimeEval(EvalPointByPoint, &p, points, expected);
+    double contiguous = TimeEval(EvalPointByPoint, &copy, points, out);
+    ok &= memcmp(expected, out, EVAL_POINTS * sizeof(poly_coeff_t)) == 0;
+    printf("%8zu %16.0f %16.0f\n", terms, original, contiguous);
+    PolyDestroy(&copy);
+    PolyDestroy(&p);
+  }
+  printf("\n");
+
+  free(points);
+  free(expected);
+  free(out);
+  return ok;
+}
+
+/**
+ * Funkcja main programu porównującego algorytmy mnożenia i wyliczania
+ * wartości.
+ * @return 0, jeśli wszystkie algorytmy dały ten sam wynik, a 1 w przeciwnym
+ * przypadku
+ */
+int main() {
+  srand(2021);
+  bool ok = BenchSeries(16) && BenchSeries(64) && BenchEval() &&
+            BenchAdd() && BenchAlloc() && BenchContiguous();
+  printf("%s\n", ok ? "OK!" : "RESULTS DIFFER!");
+  return ok ? 0 : 1;
+}
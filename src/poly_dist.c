@@ -0,0 +1,268 @@
+/** @file
+  Implementacja modułu udostępniającego wielomiany w postaci rozwiniętej
+  z upakowanymi wykładnikami
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "poly_alloc.h"
+#include "poly_dist.h"
+#include "safe_functions.h"
+
+/**
+ * Liczy zmienne, których wykładniki mieszczą się w jednym słowie.
+ * @param[in] bits : liczba bitów wykładnika jednej zmiennej
+ * @return liczba zmiennych w słowie
+ */
+static inline size_t DistVarsPerWord(unsigned int bits) {
+  return 64 / bits;
+}
+
+/**
+ * Wyznacza przesunięcie wykładnika zmiennej w jego słowie.
+ * @param[in] bits : liczba bitów wykładnika jednej zmiennej
+ * @param[in] var : indeks zmiennej
+ * @return numer najmłodszego bitu wykładnika zmiennej @f$x_{var}@f$
+ */
+static inline unsigned int DistShift(unsigned int bits, size_t var) {
+  return 64 - bits * (unsigned int)(var % DistVarsPerWord(bits) + 1);
+}
+
+/**
+ * Odczytuje wykładnik zmiennej z upakowanych wykładników.
+ * @param[in] exps : upakowane wykładniki
+ * @param[in] bits : liczba bitów wykładnika jednej zmiennej
+ * @param[in] var : indeks zmiennej
+ * @return wykładnik zmiennej @f$x_{var}@f$
+ */
+static inline poly_exp_t DistGetExp(const uint64_t exps[DIST_WORDS],
+                                    unsigned int bits, size_t var) {
+  uint64_t mask = (UINT64_C(1) << bits) - 1;
+  return (poly_exp_t)(exps[var / DistVarsPerWord(bits)] >>
+                      DistShift(bits, var) & mask);
+}
+
+/**
+ * Porównuje upakowane wykładniki dwóch jednomianów.
+ * @param[in] a : jednomian
+ * @param[in] b : jednomian
+ * @return liczba ujemna, zero lub dodatnia, jeśli wykładniki @p a są
+ * odpowiednio mniejsze, równe lub większe od wykładników @p b
+ */
+static inline int DistTermComp(const DistTerm *a, const DistTerm *b) {
+  for (size_t i = 0; i < DIST_WORDS; i++)
+    if (a->exps[i] != b->exps[i])
+      return a->exps[i] < b->exps[i] ? -1 : 1;
+  return 0;
+}
+
+/**
+ * Wyznacza największy wykładnik występujący w wielomianie.
+ * @param[in] p : wielomian
+ * @return największy wykładnik albo 0 dla wielomianu stałego
+ */
+static poly_exp_t PolyMaxExp(const Poly *p) {
+  poly_exp_t max_exp = 0;
+  if (!PolyIsCoeff(p)) {
+    Mono buffer;
+    const Mono *arr = PolyMonos(p, &buffer);
+    size_t size = PolySize(p);
+    // Jednomiany są posortowane, więc największy wykładnik tego poziomu jest
+    // w ostatnim jednomianie.
+    max_exp = arr[size - 1].exp;
+    for (size_t i = 0; i < size; i++) {
+      poly_exp_t child_exp = PolyMaxExp(&(arr[i].p));
+      if (child_exp > max_exp)
+        max_exp = child_exp;
+    }
+  }
+  return max_exp;
+}
+
+unsigned int PolyDistBits(const Poly *p) {
+  uint64_t max_exp = (uint64_t)PolyMaxExp(p);
+  unsigned int bits = 1;
+  while (bits < DIST_MAX_BITS && max_exp >> bits != 0)
+    bits++;
+  return bits;
+}
+
+/**
+ * Dopisuje jednomiany wielomianu w postaci rozwiniętej do tablicy @p dist,
+ * powiększając ją w razie potrzeby. Jednomiany są dopisywane w kolejności
+ * rosnących wykładników.
+ * @param[in] p : wielomian nad zmienną @f$x_{var}@f$
+ * @param[in] var : indeks zmiennej
+ * @param[in] exps : upakowane wykładniki zmiennych o indeksach mniejszych niż
+ * @p var
+ * @param[in,out] dist : wielomian w postaci rozwiniętej
+ * @param[in,out] capacity : rozmiar tablicy @p dist->terms
+ * @return czy wszystkie wykładniki i zmienne zmieściły się w słowach?
+ */
+static bool DistPack(const Poly *p, size_t var,
+                     const uint64_t exps[DIST_WORDS], PolyDist *dist,
+                     size_t *capacity) {
+  if (PolyIsCoeff(p)) {
+    if (!PolyIsZero(p)) {
+      if (dist->size == *capacity) {
+        *capacity = 2 * *capacity + 1;
+        dist->terms = (DistTerm *)safeRealloc(dist->terms,
+                                              *capacity * sizeof(DistTerm));
+      }
+      DistTerm *term = &(dist->terms[dist->size++]);
+      memcpy(term->exps, exps, sizeof(term->exps));
+      term->coeff = p->coeff;
+    }
+    return true;
+  }
+
+  if (var >= DIST_WORDS * DistVarsPerWord(dist->bits))
+    return false;
+
+  Mono buffer;
+  const Mono *arr = PolyMonos(p, &buffer);
+  uint64_t mask = (UINT64_C(1) << dist->bits) - 1;
+  for (size_t i = 0; i < PolySize(p); i++) {
+    if ((uint64_t)arr[i].exp > mask)
+      return false;
+
+    uint64_t child_exps[DIST_WORDS];
+    memcpy(child_exps, exps, sizeof(child_exps));
+    child_exps[var / DistVarsPerWord(dist->bits)] |=
+      (uint64_t)arr[i].exp << DistShift(dist->bits, var);
+    if (!DistPack(&(arr[i].p), var + 1, child_exps, dist, capacity))
+      return false;
+  }
+  return true;
+}
+
+bool PolyDistFromPoly(const Poly *p, unsigned int bits, PolyDist *dist) {
+  assert(bits >= 1 && bits <= DIST_MAX_BITS);
+
+  PolyDist res = {.bits = bits, .size = 0, .terms = NULL};
+  size_t capacity = 0;
+  uint64_t exps[DIST_WORDS] = {0};
+  if (!DistPack(p, 0, exps, &res, &capacity)) {
+    free(res.terms);
+    return false;
+  }
+
+  *dist = res;
+  return true;
+}
+
+/**
+ * Rozpakowuje jednomiany w postaci rozwiniętej, które mają wspólne wykładniki
+ * zmiennych o indeksach mniejszych niż @p var, do wielomianu nad zmienną
+ * @f$x_{var}@f$ w jednoznacznej, uporządkowanej postaci.
+ * @param[in] terms : niepusta tablica jednomianów posortowanych rosnąco po
+ * wykładnikach
+ * @param[in] count : liczba jednomianów
+ * @param[in] bits : liczba bitów wykładnika jednej zmiennej
+ * @param[in] var : indeks zmiennej
+ * @param[in] num_of_vars : liczba zmiennych o niezerowych wykładnikach
+ * @return wielomian
+ */
+static Poly DistUnpack(const DistTerm terms[], size_t count, unsigned int bits,
+                       size_t var, size_t num_of_vars) {
+  assert(count > 0);
+  if (var == num_of_vars) {
+    assert(count == 1);
+    return PolyFromCoeff(terms[0].coeff);
+  }
+
+  size_t size = 0;
+  for (size_t i = 0; i < count; i++)
+    if (i == 0 || DistGetExp(terms[i].exps, bits, var) !=
+                  DistGetExp(terms[i - 1].exps, bits, var))
+      size++;
+
+  Mono *arr = PolyMonosAlloc(size);
+  size_t begin = 0;
+  for (size_t i = 0; i < size; i++) {
+    poly_exp_t exp = DistGetExp(terms[begin].exps, bits, var);
+    size_t end = begin + 1;
+    while (end < count && DistGetExp(terms[end].exps, bits, var) == exp)
+      end++;
+    Poly p = DistUnpack(terms + begin, end - begin, bits, var + 1,
+                        num_of_vars);
+    arr[i] = MonoFromPoly(&p, exp);
+    begin = end;
+  }
+
+  return PolyFromMonos(size, arr);
+}
+
+Poly PolyDistToPoly(const PolyDist *dist) {
+  if (dist->size == 0)
+    return PolyZero();
+
+  // Zmienne, które mają zerowe wykładniki we wszystkich jednomianach, nie
+  // tworzą poziomów reprezentacji rekurencyjnej.
+  uint64_t used[DIST_WORDS] = {0};
+  for (size_t i = 0; i < dist->size; i++)
+    for (size_t j = 0; j < DIST_WORDS; j++)
+      used[j] |= dist->terms[i].exps[j];
+
+  size_t num_of_vars = DIST_WORDS * DistVarsPerWord(dist->bits);
+  while (num_of_vars > 0 && DistGetExp(used, dist->bits, num_of_vars - 1) == 0)
+    num_of_vars--;
+
+  return DistUnpack(dist->terms, dist->size, dist->bits, 0, num_of_vars);
+}
+
+void PolyDistDestroy(PolyDist *dist) {
+  free(dist->terms);
+}
+
+PolyDist PolyDistAdd(const PolyDist *p, const PolyDist *q) {
+  assert(p->bits == q->bits);
+
+  PolyDist res = {.bits = p->bits, .size = 0, .terms = NULL};
+  if (p->size + q->size == 0)
+    return res;
+  res.terms = (DistTerm *)safeMalloc((p->size + q->size) * sizeof(DistTerm));
+
+  size_t i = 0, j = 0;
+  while (i < p->size && j < q->size) {
+    int comp = DistTermComp(&(p->terms[i]), &(q->terms[j]));
+    if (comp < 0) {
+      res.terms[res.size++] = p->terms[i++];
+    }
+    else if (comp > 0) {
+      res.terms[res.size++] = q->terms[j++];
+    }
+    else {
+      poly_coeff_t coeff = (poly_coeff_t)((unsigned long)p->terms[i].coeff +
+                                          (unsigned long)q->terms[j].coeff);
+      if (coeff != 0) {
+        res.terms[res.size] = p->terms[i];
+        res.terms[res.size++].coeff = coeff;
+      }
+      i++;
+      j++;
+    }
+  }
+  while (i < p->size)
+    res.terms[res.size++] = p->terms[i++];
+  while (j < q->size)
+    res.terms[res.size++] = q->terms[j++];
+
+  return res;
+}
+
+bool PolyDistIsEq(const PolyDist *p, const PolyDist *q) {
+  assert(p->bits == q->bits);
+
+  if (p->size != q->size)
+    return false;
+  for (size_t i = 0; i < p->size; i++)
+    if (DistTermComp(&(p->terms[i]), &(q->terms[i])) != 0 ||
+        p->terms[i].coeff != q->terms[i].coeff)
+      return false;
+  return true;
+}
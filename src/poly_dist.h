@@ -0,0 +1,110 @@
+/** @file
+  Moduł udostępniający wielomiany w postaci rozwiniętej z upakowanymi
+  wykładnikami
+
+  W postaci rozwiniętej wielomian jest płaską tablicą jednomianów, z których
+  każdy przechowuje współczynnik i wykładniki wszystkich zmiennych upakowane
+  w DIST_WORDS 64-bitowych słowach. Zmienna @f$x_i@f$ zajmuje @p bits bitów,
+  a kolejne zmienne są umieszczane od najstarszych bitów pierwszego słowa,
+  dzięki czemu porządek jednomianów w reprezentacji rekurencyjnej jest
+  porządkiem leksykograficznym słów. Dodawanie jest scalaniem dwóch
+  posortowanych tablic, a porównanie jednomianów porównaniem liczb.
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef POLYNOMIALS_POLY_DIST_H
+#define POLYNOMIALS_POLY_DIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "poly.h"
+
+#ifndef DIST_WORDS
+/**
+ * Liczba 64-bitowych słów, w których są upakowane wykładniki jednomianu.
+ * Wartość 1 można ustawić opcją CMake POLY_DIST_WORDS.
+ */
+#define DIST_WORDS 2
+#endif
+
+#if DIST_WORDS != 1 && DIST_WORDS != 2
+#error "DIST_WORDS must be 1 or 2"
+#endif
+
+/** Największa liczba bitów przeznaczanych na wykładnik jednej zmiennej. */
+#define DIST_MAX_BITS 32
+
+/**
+ * To jest struktura przechowująca jednomian w postaci rozwiniętej.
+ */
+typedef struct DistTerm {
+  uint64_t exps[DIST_WORDS]; ///< upakowane wykładniki kolejnych zmiennych
+  poly_coeff_t coeff; ///< niezerowy współczynnik
+} DistTerm;
+
+/**
+ * To jest struktura przechowująca wielomian w postaci rozwiniętej.
+ */
+typedef struct PolyDist {
+  unsigned int bits; ///< liczba bitów wykładnika jednej zmiennej
+  size_t size; ///< liczba jednomianów
+  DistTerm *terms; ///< jednomiany posortowane rosnąco po wykładnikach
+} PolyDist;
+
+/**
+ * Wyznacza najmniejszą liczbę bitów, w której mieszczą się wszystkie
+ * wykładniki wielomianu.
+ * @param[in] p : wielomian
+ * @return liczba bitów z przedziału @f$[1, DIST\_MAX\_BITS]@f$
+ */
+unsigned int PolyDistBits(const Poly *p);
+
+/**
+ * Przekształca wielomian do postaci rozwiniętej, przeznaczając @p bits bitów
+ * na wykładnik każdej zmiennej. Jeśli któryś wykładnik nie mieści się
+ * w @p bits bitach albo wielomian zależy od więcej niż
+ * @f$DIST\_WORDS \cdot \lfloor 64 / bits \rfloor@f$ zmiennych, zwraca false
+ * i nie modyfikuje @p dist.
+ * @param[in] p : wielomian
+ * @param[in] bits : liczba bitów z przedziału @f$[1, DIST\_MAX\_BITS]@f$
+ * @param[out] dist : wskaźnik na miejsce na wielomian w postaci rozwiniętej
+ * @return czy przekształcenie się udało?
+ */
+bool PolyDistFromPoly(const Poly *p, unsigned int bits, PolyDist *dist);
+
+/**
+ * Przekształca wielomian w postaci rozwiniętej z powrotem do reprezentacji
+ * rekurencyjnej w jednoznacznej, uporządkowanej postaci.
+ * @param[in] dist : wielomian w postaci rozwiniętej
+ * @return wielomian
+ */
+Poly PolyDistToPoly(const PolyDist *dist);
+
+/**
+ * Usuwa z pamięci wielomian w postaci rozwiniętej.
+ * @param[in] dist : wielomian w postaci rozwiniętej
+ */
+void PolyDistDestroy(PolyDist *dist);
+
+/**
+ * Dodaje dwa wielomiany w postaci rozwiniętej o tej samej liczbie bitów
+ * wykładnika jednej zmiennej.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+PolyDist PolyDistAdd(const PolyDist *p, const PolyDist *q);
+
+/**
+ * Sprawdza równość dwóch wielomianów w postaci rozwiniętej o tej samej
+ * liczbie bitów wykładnika jednej zmiennej.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool PolyDistIsEq(const PolyDist *p, const PolyDist *q);
+
+#endif //POLYNOMIALS_POLY_DIST_H
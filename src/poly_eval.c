@@ -0,0 +1,198 @@
+/** @file
+  Implementacja wyliczania wartości wielomianu w wielu punktach naraz
+
+  Punkty są przetwarzane blokami po EVAL_LANES. Wartości zmiennych w bloku
+  są przechowywane kolumnami (wszystkie wartości @f$x_i@f$ obok siebie),
+  dzięki czemu pojedyncze przejście drzewa jednomianów wylicza wartości we
+  wszystkich punktach bloku, a pętle po punktach są wektoryzowane. Funkcje
+  działające na kolumnach są kompilowane w kilku wariantach dla różnych
+  rozszerzeń procesora, a właściwy wariant jest wybierany w czasie działania
+  programu.
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <stdlib.h>
+
+#include "poly.h"
+#include "poly_alloc.h"
+#include "safe_functions.h"
+
+/** Liczba punktów przetwarzanych jednym przejściem drzewa jednomianów. */
+#define EVAL_LANES 64
+
+#if defined(__x86_64__) && defined(__linux__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+/**
+ * Kompiluje funkcję w wariantach dla AVX-512, AVX2 i zwykłego x86-64.
+ * Wariant jest wybierany przy pierwszym wywołaniu na podstawie procesora.
+ */
+#define EVAL_KERNEL \
+  __attribute__((target_clones("arch=x86-64-v4", "avx2", "default")))
+#endif
+#endif
+
+#ifndef EVAL_KERNEL
+/** Na innych platformach funkcje są kompilowane w jednym wariancie. */
+#define EVAL_KERNEL
+#endif
+
+/**
+ * Ustawia wszystkie wartości kolumny na @p c.
+ * @param[out] res : kolumna
+ * @param[in] c : wartość
+ */
+EVAL_KERNEL
+static void LanesFill(unsigned long res[EVAL_LANES], unsigned long c) {
+  for (size_t j = 0; j < EVAL_LANES; j++)
+    res[j] = c;
+}
+
+/**
+ * Dodaje do wartości kolumny @p res wartości kolumny @p add.
+ * @param[in,out] res : kolumna
+ * @param[in] add : kolumna
+ */
+EVAL_KERNEL
+static void LanesAdd(unsigned long res[EVAL_LANES],
+                     const unsigned long add[EVAL_LANES]) {
+  for (size_t j = 0; j < EVAL_LANES; j++)
+    res[j] += add[j];
+}
+
+/**
+ * Dodaje liczbę do wszystkich wartości kolumny.
+ * @param[in,out] res : kolumna
+ * @param[in] c : liczba
+ */
+EVAL_KERNEL
+static void LanesAddCoeff(unsigned long res[EVAL_LANES], unsigned long c) {
+  for (size_t j = 0; j < EVAL_LANES; j++)
+    res[j] += c;
+}
+
+/**
+ * Mnoży wartości kolumny @p res przez kolejne wartości kolumny @p x
+ * podniesione do potęgi @p exp. Potęgi są liczone przez podnoszenie do
+ * kwadratu dla wszystkich punktów naraz.
+ * @param[in,out] res : kolumna
+ * @param[in] x : kolumna wartości zmiennej
+ * @param[in] exp : wykładnik
+ */
+EVAL_KERNEL
+static void LanesMulPower(unsigned long res[EVAL_LANES],
+                          const unsigned long x[EVAL_LANES], poly_exp_t exp) {
+  unsigned long base[EVAL_LANES];
+  for (size_t j = 0; j < EVAL_LANES; j++)
+    base[j] = x[j];
+  while (exp > 0) {
+    if (exp % 2 == 1)
+      for (size_t j = 0; j < EVAL_LANES; j++)
+        res[j] *= base[j];
+    exp /= 2;
+    if (exp > 0)
+      for (size_t j = 0; j < EVAL_LANES; j++)
+        base[j] *= base[j];
+  }
+}
+
+/**
+ * Liczy głębokość wielomianu, czyli liczbę poziomów jednomianów.
+ * @param[in] p : wielomian
+ * @return głębokość wielomianu
+ */
+static size_t PolyDepth(const Poly *p) {
+  size_t depth = 0;
+  if (!PolyIsCoeff(p)) {
+    Mono buffer;
+    const Mono *arr = PolyMonos(p, &buffer);
+    for (size_t i = 0; i < PolySize(p); i++) {
+      size_t child_depth = PolyDepth(&(arr[i].p));
+      if (child_depth > depth)
+        depth = child_depth;
+    }
+    depth++;
+  }
+  return depth;
+}
+
+/**
+ * Wylicza wartości wielomianu we wszystkich punktach bloku, podstawiając
+ * w miejsce zmiennej @f$x_i@f$ kolumnę @p xs[i + index]. Jeśli
+ * @f$i + index \geq k@f$, w miejsce @f$x_i@f$ podstawia @f$0@f$.
+ * @param[in] p : wielomian
+ * @param[in] k : liczba kolumn w @p xs
+ * @param[in] xs : kolumny wartości kolejnych zmiennych
+ * @param[in] index : indeks kolumny w @p xs do podstawienia za @f$x_0@f$
+ * @param[in] buffers : kolumny pomocnicze, po jednej na poziom wielomianu
+ * @param[out] res : kolumna na wartości wielomianu
+ */
+static void PolyEvalLanes(const Poly *p, size_t k,
+                          const unsigned long (*xs)[EVAL_LANES], size_t index,
+                          unsigned long (*buffers)[EVAL_LANES],
+                          unsigned long res[EVAL_LANES]) {
+  if (PolyIsCoeff(p)) {
+    LanesFill(res, (unsigned long)p->coeff);
+    return;
+  }
+
+  Mono mono_buffer;
+  const Mono *arr = PolyMonos(p, &mono_buffer);
+  if (index >= k) {
+    if (arr[0].exp == 0)
+      PolyEvalLanes(&(arr[0].p), k, xs, index + 1, buffers, res);
+    else
+      LanesFill(res, 0);
+  }
+  else {
+    // Schemat Hornera po różnicach kolejnych wykładników, jak w PolyEval.
+    size_t i = PolySize(p) - 1;
+    PolyEvalLanes(&(arr[i].p), k, xs, index + 1, buffers + 1, res);
+    while (i > 0) {
+      LanesMulPower(res, xs[index], arr[i].exp - arr[i - 1].exp);
+      i--;
+      if (PolyIsCoeff(&(arr[i].p))) {
+        LanesAddCoeff(res, (unsigned long)arr[i].p.coeff);
+      }
+      else {
+        PolyEvalLanes(&(arr[i].p), k, xs, index + 1, buffers + 1,
+                      buffers[0]);
+        LanesAdd(res, buffers[0]);
+      }
+    }
+    LanesMulPower(res, xs[index], arr[0].exp);
+  }
+}
+
+void PolyEvalBatch(const Poly *p, size_t k, size_t n,
+                   const poly_coeff_t points[], poly_coeff_t out[]) {
+  // Zmienne, których wielomian nie zawiera, nie muszą być przepisywane.
+  size_t depth = PolyDepth(p);
+  size_t used_k = k < depth ? k : depth;
+  unsigned long (*xs)[EVAL_LANES] =
+    safeMalloc((used_k + 1) * sizeof(unsigned long[EVAL_LANES]));
+  unsigned long (*buffers)[EVAL_LANES] =
+    safeMalloc((depth + 1) * sizeof(unsigned long[EVAL_LANES]));
+  unsigned long res[EVAL_LANES];
+
+  for (size_t begin = 0; begin < n; begin += EVAL_LANES) {
+    size_t lanes = n - begin < EVAL_LANES ? n - begin : EVAL_LANES;
+    // Transpozycja bloku punktów do kolumn. Nieużywane miejsca w ostatnim
+    // bloku są wypełniane zerami.
+    for (size_t i = 0; i < used_k; i++) {
+      for (size_t j = 0; j < lanes; j++)
+        xs[i][j] = (unsigned long)points[(begin + j) * k + i];
+      for (size_t j = lanes; j < EVAL_LANES; j++)
+        xs[i][j] = 0;
+    }
+
+    PolyEvalLanes(p, used_k, (const unsigned long (*)[EVAL_LANES])xs, 0,
+                  buffers, res);
+    for (size_t j = 0; j < lanes; j++)
+      out[begin + j] = (poly_coeff_t)res[j];
+  }
+
+  free(xs);
+  free(buffers);
+}
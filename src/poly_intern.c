@@ -0,0 +1,226 @@
+/** @file
+  Implementacja modułu przechowującego tablicę unikatową poziomów wielomianów
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "poly_alloc.h"
+#include "poly_intern.h"
+#include "safe_functions.h"
+
+#ifdef POLY_HASH_CONS
+#include <pthread.h>
+
+/** Początkowa liczba miejsc tablicy unikatowej. */
+#define INTERN_MIN_CAPACITY 64
+
+/**
+ * To jest struktura przechowująca jedno miejsce tablicy unikatowej.
+ */
+typedef struct InternEntry {
+  Mono *arr; ///< tablica jednomianów, NULL albo INTERN_REMOVED
+  size_t size; ///< liczba jednomianów tablicy
+  uint64_t hash; ///< skrót struktury tablicy
+} InternEntry;
+
+/** Zastępuje w miejscu tablicy unikatowej usuniętą z niej tablicę. */
+static Mono intern_removed;
+
+/** Oznaczenie miejsca, z którego usunięto tablicę. */
+#define INTERN_REMOVED (&intern_removed)
+
+/** Miejsca tablicy unikatowej, których liczba jest potęgą dwójki. */
+static InternEntry *intern_entries = NULL;
+
+/** Liczba miejsc tablicy unikatowej. */
+static size_t intern_capacity = 0;
+
+/** Liczba tablic jednomianów w tablicy unikatowej. */
+static size_t intern_count = 0;
+
+/** Liczba miejsc zajętych przez tablice albo oznaczonych jako usunięte. */
+static size_t intern_used = 0;
+
+/** Chroni tablicę unikatową i liczniki odwołań umieszczonych w niej tablic. */
+static pthread_mutex_t intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Miesza bity liczby (funkcja kończąca generatora SplitMix64).
+ * @param[in] x : liczba
+ * @return wymieszana liczba
+ */
+static inline uint64_t InternMix(uint64_t x) {
+  x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return x ^ (x >> 31);
+}
+
+/**
+ * Wyznacza skrót struktury poziomu wielomianu. Jednomiany poziomu są
+ * w tablicy unikatowej, więc wystarczy skrót ich adresów.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return skrót
+ */
+static uint64_t InternHash(const Poly *p) {
+  uint64_t hash = InternMix(p->size);
+  for (size_t i = 0; i < p->size; i++) {
+    const Poly *child = &(p->arr[i].p);
+    hash = InternMix(hash ^ (uint64_t)p->arr[i].exp);
+    // Jednomian przechowywany bez tablicy to współczynnik i wykładnik.
+    hash = InternMix(hash ^ (PolyIsCoeff(child) || PolyIsInline(child) ?
+                             (uint64_t)child->coeff : 0));
+    hash = InternMix(hash ^ (uint64_t)(uintptr_t)child->arr);
+  }
+  return hash;
+}
+
+/**
+ * Sprawdza, czy miejsce tablicy unikatowej zawiera poziom równy @p p.
+ * @param[in] entry : zajęte miejsce tablicy unikatowej
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] hash : skrót @p p
+ * @return czy poziomy są równe?
+ */
+static bool InternIsEq(const InternEntry *entry, const Poly *p,
+                       uint64_t hash) {
+  if (entry->hash != hash || entry->size != p->size)
+    return false;
+  for (size_t i = 0; i < p->size; i++) {
+    const Mono *m = &(entry->arr[i]), *n = &(p->arr[i]);
+    if (m->exp != n->exp || m->p.arr != n->p.arr)
+      return false;
+    if ((PolyIsCoeff(&(m->p)) || PolyIsInline(&(m->p))) &&
+        m->p.coeff != n->p.coeff)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Przebudowuje tablicę unikatową, pomijając usunięte miejsca, tak aby
+ * co najwyżej ćwierć miejsc była zajęta.
+ */
+static void InternResize(void) {
+  size_t capacity = INTERN_MIN_CAPACITY;
+  while (capacity < 4 * (intern_count + 1))
+    capacity *= 2;
+
+  InternEntry *entries =
+    (InternEntry *)safeMalloc(capacity * sizeof(InternEntry));
+  for (size_t i = 0; i < capacity; i++)
+    entries[i].arr = NULL;
+  for (size_t i = 0; i < intern_capacity; i++) {
+    Mono *arr = intern_entries[i].arr;
+    if (arr == NULL || arr == INTERN_REMOVED)
+      continue;
+    size_t j = intern_entries[i].hash & (capacity - 1);
+    while (entries[j].arr != NULL)
+      j = (j + 1) & (capacity - 1);
+    entries[j] = intern_entries[i];
+  }
+
+  free(intern_entries);
+  intern_entries = entries;
+  intern_capacity = capacity;
+  intern_used = intern_count;
+}
+
+Poly PolyIntern(Poly *p) {
+  if (PolyIsCoeff(p) || PolyIsInline(p) || PolyMonosIsInterned(p->arr) ||
+      PolyMonosIsInArena(p->arr))
+    return *p;
+  for (size_t i = 0; i < p->size; i++) {
+    const Poly *child = &(p->arr[i].p);
+    if (!PolyIsCoeff(child) && !PolyIsInline(child) &&
+        !PolyIsInterned(child))
+      return *p;
+  }
+
+  uint64_t hash = InternHash(p);
+  pthread_mutex_lock(&intern_mutex);
+  if (2 * (intern_used + 1) > intern_capacity)
+    InternResize();
+
+  size_t mask = intern_capacity - 1;
+  size_t i = hash & mask, free_slot = SIZE_MAX;
+  while (intern_entries[i].arr != NULL) {
+    if (intern_entries[i].arr == INTERN_REMOVED) {
+      if (free_slot == SIZE_MAX)
+        free_slot = i;
+    }
+    else if (InternIsEq(&(intern_entries[i]), p, hash)) {
+      Poly found = {.size = p->size, .arr = intern_entries[i].arr};
+      PolyMonosRetain(found.arr);
+      pthread_mutex_unlock(&intern_mutex);
+      PolyDestroy(p);
+      return found;
+    }
+    i = (i + 1) & mask;
+  }
+
+  if (free_slot == SIZE_MAX) {
+    free_slot = i;
+    intern_used++;
+  }
+  intern_entries[free_slot] = (InternEntry) {.arr = p->arr, .size = p->size,
+                                             .hash = hash};
+  intern_count++;
+  PolyMonosSetInterned(p->arr);
+  pthread_mutex_unlock(&intern_mutex);
+  return *p;
+}
+
+bool PolyInternRelease(const Poly *p) {
+  assert(!PolyIsCoeff(p) && !PolyIsInline(p));
+  if (!PolyMonosIsInterned(p->arr))
+    return PolyMonosRelease(p->arr);
+
+  // Odwołania do tablic z tablicy unikatowej są dodawane przy wyszukiwaniu
+  // pod ochroną muteksu, więc ostatnie odwołanie musi być usuwane również
+  // pod jego ochroną.
+  uint64_t hash = InternHash(p);
+  pthread_mutex_lock(&intern_mutex);
+  bool is_last = PolyMonosRelease(p->arr);
+  if (is_last) {
+    size_t i = hash & (intern_capacity - 1);
+    while (intern_entries[i].arr != p->arr)
+      i = (i + 1) & (intern_capacity - 1);
+    intern_entries[i].arr = INTERN_REMOVED;
+    intern_count--;
+  }
+  pthread_mutex_unlock(&intern_mutex);
+  return is_last;
+}
+
+size_t PolyInternCount(void) {
+  pthread_mutex_lock(&intern_mutex);
+  size_t count = intern_count;
+  pthread_mutex_unlock(&intern_mutex);
+  return count;
+}
+
+#else
+
+Poly PolyIntern(Poly *p) {
+  return *p;
+}
+
+bool PolyInternRelease(const Poly *p) {
+  assert(!PolyIsCoeff(p) && !PolyIsInline(p));
+  return PolyMonosRelease(p->arr);
+}
+
+size_t PolyInternCount(void) {
+  return 0;
+}
+
+#endif /* POLY_HASH_CONS */
+
+bool PolyIsInterned(const Poly *p) {
+  return !PolyIsCoeff(p) && !PolyIsInline(p) &&
+         PolyMonosIsInterned(p->arr);
+}
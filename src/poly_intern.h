@@ -0,0 +1,61 @@
+/** @file
+  Moduł przechowujący tablicę unikatową poziomów wielomianów
+
+  Jeśli zdefiniowano POLY_HASH_CONS (opcja CMake o tej samej nazwie), każdy
+  poziom wielomianu w jednoznacznej, uporządkowanej postaci, którego
+  jednomiany są już w tablicy unikatowej, jest w niej wyszukiwany po
+  skrócie swojej struktury. Równe poziomy są wtedy reprezentowane przez jedną
+  tablicę jednomianów z licznikiem odwołań, więc zajmowana pamięć zależy od
+  liczby różnych poziomów, a równość wielomianów z tablicy unikatowej jest
+  równością wskaźników. Tablica jest usuwana z tablicy unikatowej wraz
+  z ostatnim odwołaniem do niej.
+
+  Tablice przydzielone z obszaru nie trafiają do tablicy unikatowej. Bez
+  POLY_HASH_CONS funkcje modułu nie zmieniają wielomianów.
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef POLYNOMIALS_POLY_INTERN_H
+#define POLYNOMIALS_POLY_INTERN_H
+
+#include <stdbool.h>
+
+#include "poly.h"
+
+/**
+ * Wyszukuje wielomian w tablicy unikatowej i dodaje go do niej, jeśli go tam
+ * nie ma. Wielomian, którego któryś jednomian nie jest w tablicy unikatowej,
+ * nie jest do niej dodawany.
+ * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
+ * @param[in] p : wielomian w jednoznacznej, uporządkowanej postaci
+ * @return wielomian równy @p p, być może współdzielący tablicę jednomianów
+ * z innym wielomianem
+ */
+Poly PolyIntern(Poly *p);
+
+/**
+ * Sprawdza, czy tablica jednomianów wielomianu jest w tablicy unikatowej.
+ * @param[in] p : wielomian
+ * @return czy @p p nie jest współczynnikiem i jest w tablicy unikatowej?
+ */
+bool PolyIsInterned(const Poly *p);
+
+/**
+ * Usuwa odwołanie do tablicy jednomianów wielomianu niebędącego
+ * współczynnikiem. Jeśli było to ostatnie odwołanie, usuwa tablicę z tablicy
+ * unikatowej.
+ * @param[in] p : wielomian
+ * @return czy było to ostatnie odwołanie? Wtedy wywołujący usuwa jednomiany
+ * tablicy i zwalnia ją przez PolyMonosFree.
+ */
+bool PolyInternRelease(const Poly *p);
+
+/**
+ * Podaje liczbę tablic jednomianów w tablicy unikatowej.
+ * @return liczba tablic
+ */
+size_t PolyInternCount(void);
+
+#endif //POLYNOMIALS_POLY_INTERN_H
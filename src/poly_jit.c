@@ -0,0 +1,213 @@
+/** @file
+  Implementacja modułu udostępniającego wielomiany przetłumaczone na kod
+  maszynowy x86-64
+
+  Wygenerowana funkcja ma sygnaturę
+  `unsigned long f(const unsigned long *regs, unsigned long *stack)` zgodną
+  z konwencją wywołań System V: @p regs (rejestr rdi) wskazuje na potęgi
+  wyliczone przez PolyProgramLoad, a @p stack (rejestr rsi) na pamięć stosu
+  programu. Szczyt stosu jest trzymany w rejestrze rax, a niższe wartości są
+  odkładane do pamięci.
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+// Poniższa dyrektywa zapewnia dostępność funkcji mmap i stałej MAP_ANONYMOUS.
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "poly_jit.h"
+#include "safe_functions.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+/** Generowanie kodu maszynowego jest dostępne na tej platformie. */
+#define JIT_ENABLED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+/** Generowanie kodu maszynowego nie jest dostępne na tej platformie. */
+#define JIT_ENABLED 0
+#endif
+
+/** To jest typ funkcji wygenerowanej przez moduł. */
+typedef unsigned long (*jit_function_t)(const unsigned long *regs,
+                                        unsigned long *stack);
+
+#if JIT_ENABLED
+
+/**
+ * To jest struktura przechowująca generowany kod maszynowy.
+ */
+typedef struct JitBuffer {
+  unsigned char *bytes; ///< wygenerowane bajty
+  size_t size; ///< liczba wygenerowanych bajtów
+  size_t capacity; ///< rozmiar tablicy @p bytes
+} JitBuffer;
+
+/**
+ * Dopisuje bajty na koniec generowanego kodu.
+ * @param[in,out] buffer : generowany kod
+ * @param[in] bytes : bajty
+ * @param[in] count : liczba bajtów
+ */
+static void JitEmit(JitBuffer *buffer, const void *bytes, size_t count) {
+  if (buffer->size + count > buffer->capacity) {
+    buffer->capacity = 2 * (buffer->size + count);
+    buffer->bytes = (unsigned char *)safeRealloc(buffer->bytes,
+                                                 buffer->capacity);
+  }
+  memcpy(buffer->bytes + buffer->size, bytes, count);
+  buffer->size += count;
+}
+
+/**
+ * Dopisuje instrukcję odwołującą się do potęgi @p reg, czyli do pamięci pod
+ * adresem @f$rdi + 8 \cdot reg@f$.
+ * @param[in,out] buffer : generowany kod
+ * @param[in] opcode : kod instrukcji wraz z bajtem ModRM
+ * @param[in] opcode_size : liczba bajtów @p opcode
+ * @param[in] reg : numer potęgi
+ */
+static void JitEmitWithReg(JitBuffer *buffer, const unsigned char *opcode,
+                           size_t opcode_size, unsigned int reg) {
+  uint32_t disp = (uint32_t)reg * 8;
+  JitEmit(buffer, opcode, opcode_size);
+  JitEmit(buffer, &disp, sizeof(disp));
+}
+
+/**
+ * Dopisuje instrukcję dodającą stałą do rejestru rax.
+ * @param[in,out] buffer : generowany kod
+ * @param[in] value : stała
+ */
+static void JitEmitAddConst(JitBuffer *buffer, poly_coeff_t value) {
+  if (value >= INT32_MIN && value <= INT32_MAX) {
+    static const unsigned char add_rax_imm32[] = {0x48, 0x05};
+    int32_t imm = (int32_t)value;
+    JitEmit(buffer, add_rax_imm32, sizeof(add_rax_imm32));
+    JitEmit(buffer, &imm, sizeof(imm));
+  }
+  else {
+    static const unsigned char mov_rdx_imm64[] = {0x48, 0xBA};
+    static const unsigned char add_rax_rdx[] = {0x48, 0x01, 0xD0};
+    JitEmit(buffer, mov_rdx_imm64, sizeof(mov_rdx_imm64));
+    JitEmit(buffer, &value, sizeof(value));
+    JitEmit(buffer, add_rax_rdx, sizeof(add_rax_rdx));
+  }
+}
+
+/**
+ * Tłumaczy program na kod maszynowy.
+ * @param[in] program : program
+ * @param[out] buffer : generowany kod
+ */
+static void JitTranslate(const PolyProgram *program, JitBuffer *buffer) {
+  static const unsigned char mov_mem_rsi_rax[] = {0x48, 0x89, 0x06};
+  static const unsigned char add_rsi_8[] = {0x48, 0x83, 0xC6, 0x08};
+  static const unsigned char sub_rsi_8[] = {0x48, 0x83, 0xEE, 0x08};
+  static const unsigned char mov_rax_imm64[] = {0x48, 0xB8};
+  static const unsigned char mov_rdx_mem_rsi[] = {0x48, 0x8B, 0x16};
+  static const unsigned char imul_rax_mem_rdi[] = {0x48, 0x0F, 0xAF, 0x87};
+  static const unsigned char imul_rdx_mem_rdi[] = {0x48, 0x0F, 0xAF, 0x97};
+  static const unsigned char add_rax_rdx[] = {0x48, 0x01, 0xD0};
+  static const unsigned char ret[] = {0xC3};
+
+  for (size_t i = 0; i < program->code_size; i++) {
+    const ProgramInstr *instr = &(program->code[i]);
+    switch (instr->op) {
+      case PROGRAM_CONST:
+        // Poprzedni szczyt stosu jest odkładany do pamięci. Przy pierwszej
+        // instrukcji odkładana jest nieistotna wartość, na co wystarcza
+        // miejsca, bo stos w pamięci ma program->stack_size miejsc.
+        JitEmit(buffer, mov_mem_rsi_rax, sizeof(mov_mem_rsi_rax));
+        JitEmit(buffer, add_rsi_8, sizeof(add_rsi_8));
+        JitEmit(buffer, mov_rax_imm64, sizeof(mov_rax_imm64));
+        JitEmit(buffer, &(instr->value), sizeof(instr->value));
+        break;
+      case PROGRAM_MUL:
+        JitEmitWithReg(buffer, imul_rax_mem_rdi, sizeof(imul_rax_mem_rdi),
+                       instr->reg);
+        break;
+      case PROGRAM_MULADDC:
+        JitEmitWithReg(buffer, imul_rax_mem_rdi, sizeof(imul_rax_mem_rdi),
+                       instr->reg);
+        if (instr->value != 0)
+          JitEmitAddConst(buffer, instr->value);
+        break;
+      case PROGRAM_MULADD:
+        JitEmit(buffer, sub_rsi_8, sizeof(sub_rsi_8));
+        JitEmit(buffer, mov_rdx_mem_rsi, sizeof(mov_rdx_mem_rsi));
+        JitEmitWithReg(buffer, imul_rdx_mem_rdi, sizeof(imul_rdx_mem_rdi),
+                       instr->reg);
+        JitEmit(buffer, add_rax_rdx, sizeof(add_rax_rdx));
+        break;
+      case PROGRAM_RET:
+        JitEmit(buffer, ret, sizeof(ret));
+        break;
+    }
+  }
+}
+
+/**
+ * Kopiuje kod maszynowy do nowego obszaru pamięci i oznacza go jako
+ * wykonywalny. Obszar nigdy nie jest jednocześnie zapisywalny i wykonywalny.
+ * @param[in] jit : przetłumaczony wielomian, któremu przypisywany jest obszar
+ * @param[in] buffer : wygenerowany kod
+ */
+static void JitMap(PolyJit *jit, const JitBuffer *buffer) {
+  size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  size_t size = (buffer->size + page_size - 1) / page_size * page_size;
+  void *code = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED)
+    return;
+
+  memcpy(code, buffer->bytes, buffer->size);
+  if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+    munmap(code, size);
+    return;
+  }
+  jit->code = code;
+  jit->code_size = size;
+}
+
+#endif
+
+PolyJit PolyJitNew(const Poly *p) {
+  PolyJit jit = {.program = PolyProgramNew(p), .code = NULL, .code_size = 0};
+#if JIT_ENABLED
+  JitBuffer buffer = {.bytes = NULL, .size = 0, .capacity = 0};
+  JitTranslate(&(jit.program), &buffer);
+  JitMap(&jit, &buffer);
+  free(buffer.bytes);
+#endif
+  return jit;
+}
+
+void PolyJitDestroy(PolyJit *jit) {
+#if JIT_ENABLED
+  if (jit->code != NULL)
+    munmap(jit->code, jit->code_size);
+#endif
+  PolyProgramDestroy(&(jit->program));
+}
+
+bool PolyJitIsNative(const PolyJit *jit) {
+  return jit->code != NULL;
+}
+
+poly_coeff_t PolyJitEval(PolyJit *jit, size_t k, const poly_coeff_t x[]) {
+  if (jit->code == NULL)
+    return PolyProgramEval(&(jit->program), k, x);
+
+  unsigned long *regs = PolyProgramLoad(&(jit->program), k, x);
+  jit_function_t function;
+  // Konwersja wskaźnika na dane na wskaźnik na funkcję przez memcpy, bo
+  // standard C nie definiuje bezpośredniego rzutowania.
+  memcpy(&function, &(jit->code), sizeof(function));
+  return (poly_coeff_t)function(regs, regs + jit->program.num_of_powers);
+}
@@ -0,0 +1,64 @@
+/** @file
+  Moduł udostępniający wielomiany przetłumaczone na kod maszynowy x86-64
+
+  Wielomian jest najpierw kompilowany do programu z modułu poly_program,
+  a następnie każda instrukcja programu jest tłumaczona na kilka instrukcji
+  procesora zapisywanych w wykonywalnym obszarze pamięci. Na platformach
+  innych niż x86-64 albo gdy system nie pozwala utworzyć wykonywalnego obszaru
+  pamięci wartości są wyliczane interpreterem programu.
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef POLYNOMIALS_POLY_JIT_H
+#define POLYNOMIALS_POLY_JIT_H
+
+#include <stdbool.h>
+
+#include "poly.h"
+#include "poly_program.h"
+
+/**
+ * To jest struktura przechowująca wielomian przetłumaczony na kod maszynowy.
+ */
+typedef struct PolyJit {
+  PolyProgram program; ///< program, z którego powstał kod maszynowy
+  void *code; ///< wykonywalny obszar pamięci albo NULL, jeśli go nie ma
+  size_t code_size; ///< rozmiar obszaru @p code
+} PolyJit;
+
+/**
+ * Tłumaczy wielomian na kod maszynowy wyliczający jego wartości.
+ * @param[in] p : wielomian
+ * @return przetłumaczony wielomian
+ */
+PolyJit PolyJitNew(const Poly *p);
+
+/**
+ * Usuwa z pamięci przetłumaczony wielomian.
+ * @param[in] jit : przetłumaczony wielomian
+ */
+void PolyJitDestroy(PolyJit *jit);
+
+/**
+ * Sprawdza, czy wartości wielomianu są wyliczane kodem maszynowym, a nie
+ * interpreterem programu.
+ * @param[in] jit : przetłumaczony wielomian
+ * @return czy powstał kod maszynowy?
+ */
+bool PolyJitIsNative(const PolyJit *jit);
+
+/**
+ * Wylicza wartość przetłumaczonego wielomianu w punkcie
+ * @f$(x_0, x_1, \ldots, x_{k-1})@f$, tak jak PolyEval. Korzysta z pamięci
+ * roboczej programu, więc nie może być wykonywana współbieżnie dla jednego
+ * wielomianu.
+ * @param[in] jit : przetłumaczony wielomian
+ * @param[in] k : rozmiar tablicy @p x
+ * @param[in] x : wartości kolejnych zmiennych
+ * @return wartość wielomianu
+ */
+poly_coeff_t PolyJitEval(PolyJit *jit, size_t k, const poly_coeff_t x[]);
+
+#endif //POLYNOMIALS_POLY_JIT_H
@@ -0,0 +1,1091 @@
+/** @file
+  Implementacja modułu udostępniającego szybkie algorytmy mnożenia wielomianów
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+// Poniższa dyrektywa zapewnia dostępność wątków POSIX i funkcji sysconf.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "poly_alloc.h"
+#include "poly_mul.h"
+#include "safe_functions.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+/** Mnożenie wielowątkowe jest dostępne na tej platformie. */
+#define PARALLEL_ENABLED 1
+#include <pthread.h>
+#include <unistd.h>
+#else
+/** Mnożenie wielowątkowe nie jest dostępne na tej platformie. */
+#define PARALLEL_ENABLED 0
+#endif
+
+/**
+ * Minimalna liczba iloczynów jednomianów stałych, od której opłaca się
+ * podstawienie Kroneckera.
+ */
+#define KRONECKER_MIN_PRODUCTS 64
+
+/**
+ * Długość tablic współczynników, poniżej której algorytm Karatsuby przechodzi
+ * na mnożenie szkolne.
+ */
+#define KARATSUBA_THRESHOLD 32
+
+/**
+ * Liczba współczynników krótszego czynnika, od której mnożenie gęstych
+ * wielomianów jednej zmiennej wykorzystuje szybką transformatę teoretyczno-
+ * liczbową zamiast algorytmu Karatsuby, jeśli wystarcza jedna liczba
+ * pierwsza. Dla @f$k@f$ liczb pierwszych próg jest @f$k^2@f$ razy większy.
+ * Wartość dobrana na podstawie wyników programu poly_bench.
+ */
+#define NTT_THRESHOLD 4096
+
+/**
+ * Minimalna liczba iloczynów jednomianów stałych, od której mnożenie jest
+ * rozdzielane między wątki. Poniżej tej liczby koszt tworzenia wątków
+ * przewyższa zysk.
+ */
+#define PARALLEL_MIN_PRODUCTS (1 << 20)
+
+/** Liczba liczb pierwszych, modulo które liczone są transformaty. */
+#define NTT_NUM_OF_PRIMES 3
+
+/**
+ * Liczba bitów, poniżej której liczba jest zawsze mniejsza od każdej z liczb
+ * pierwszych.
+ */
+#define NTT_PRIME_BITS 61
+
+/**
+ * Mnoży dwa współczynniki modulo @f$2^{64}@f$, tak jak robi to PolyMul,
+ * ale bez niezdefiniowanego zachowania przy przepełnieniu.
+ * @param[in] a : współczynnik @f$a@f$
+ * @param[in] b : współczynnik @f$b@f$
+ * @return @f$a * b@f$
+ */
+static inline poly_coeff_t CoeffMul(poly_coeff_t a, poly_coeff_t b) {
+  return (poly_coeff_t)((unsigned long)a * (unsigned long)b);
+}
+
+/**
+ * Dodaje dwa współczynniki modulo @f$2^{64}@f$, tak jak robi to PolyAdd,
+ * ale bez niezdefiniowanego zachowania przy przepełnieniu.
+ * @param[in] a : współczynnik @f$a@f$
+ * @param[in] b : współczynnik @f$b@f$
+ * @return @f$a + b@f$
+ */
+static inline poly_coeff_t CoeffAdd(poly_coeff_t a, poly_coeff_t b) {
+  return (poly_coeff_t)((unsigned long)a + (unsigned long)b);
+}
+
+/**
+ * Odejmuje dwa współczynniki modulo @f$2^{64}@f$.
+ * @param[in] a : współczynnik @f$a@f$
+ * @param[in] b : współczynnik @f$b@f$
+ * @return @f$a - b@f$
+ */
+static inline poly_coeff_t CoeffSub(poly_coeff_t a, poly_coeff_t b) {
+  return (poly_coeff_t)((unsigned long)a - (unsigned long)b);
+}
+
+void DenseMulSchoolbook(const poly_coeff_t a[], size_t n,
+                        const poly_coeff_t b[], size_t m, poly_coeff_t res[]) {
+  for (size_t k = 0; k < n + m - 1; k++)
+    res[k] = 0;
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < m; j++)
+      res[i + j] = CoeffAdd(res[i + j], CoeffMul(a[i], b[j]));
+}
+
+/**
+ * Wylicza rozmiar pamięci pomocniczej potrzebnej funkcji KaratsubaRec.
+ * @param[in] n : liczba współczynników każdego z czynników
+ * @return liczba współczynników pamięci pomocniczej
+ */
+static size_t KaratsubaScratchSize(size_t n) {
+  if (n <= KARATSUBA_THRESHOLD)
+    return 0;
+  size_t high = n - n / 2;
+  return 4 * high - 1 + KaratsubaScratchSize(high);
+}
+
+/**
+ * Mnoży dwa gęste wielomiany jednej zmiennej o równej liczbie współczynników
+ * algorytmem Karatsuby. Czynniki dzielone są na połowy @f$a = a_0 + a_1x^h@f$,
+ * @f$b = b_0 + b_1x^h@f$, a iloczyn wyznaczany jest z trzech iloczynów:
+ * @f$a_0b_0@f$, @f$a_1b_1@f$ i @f$(a_0 + a_1)(b_0 + b_1)@f$. Wszystkie
+ * działania są wykonywane modulo @f$2^{64}@f$, więc wynik jest dokładnie taki
+ * sam jak przy mnożeniu szkolnym.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] n : liczba współczynników każdego z czynników
+ * @param[out] res : tablica na @f$2n - 1@f$ współczynników iloczynu
+ * @param[in] scratch : pamięć pomocnicza o rozmiarze co najmniej
+ * KaratsubaScratchSize(n)
+ */
+static void KaratsubaRec(const poly_coeff_t a[], const poly_coeff_t b[],
+                         size_t n, poly_coeff_t res[], poly_coeff_t scratch[]) {
+  if (n <= KARATSUBA_THRESHOLD) {
+    DenseMulSchoolbook(a, n, b, n, res);
+    return;
+  }
+
+  size_t low = n / 2, high = n - low;
+  poly_coeff_t *a_sum = scratch;
+  poly_coeff_t *b_sum = a_sum + high;
+  poly_coeff_t *mid = b_sum + high;
+  poly_coeff_t *rest = mid + 2 * high - 1;
+
+  // res[0 .. 2low - 2] = a_0 * b_0, res[2low .. 2n - 2] = a_1 * b_1
+  KaratsubaRec(a, b, low, res, rest);
+  res[2 * low - 1] = 0;
+  KaratsubaRec(a + low, b + low, high, res + 2 * low, rest);
+
+  for (size_t i = 0; i < high; i++) {
+    a_sum[i] = i < low ? CoeffAdd(a[i], a[low + i]) : a[low + i];
+    b_sum[i] = i < low ? CoeffAdd(b[i], b[low + i]) : b[low + i];
+  }
+  KaratsubaRec(a_sum, b_sum, high, mid, rest);
+
+  for (size_t i = 0; i < 2 * low - 1; i++)
+    mid[i] = CoeffSub(mid[i], res[i]);
+  for (size_t i = 0; i < 2 * high - 1; i++)
+    mid[i] = CoeffSub(mid[i], res[2 * low + i]);
+  for (size_t i = 0; i < 2 * high - 1; i++)
+    res[low + i] = CoeffAdd(res[low + i], mid[i]);
+}
+
+void DenseMulKaratsuba(const poly_coeff_t a[], size_t n,
+                       const poly_coeff_t b[], size_t m, poly_coeff_t res[]) {
+  if (n > m) {
+    DenseMulKaratsuba(b, m, a, n, res);
+    return;
+  }
+  if (n <= KARATSUBA_THRESHOLD) {
+    DenseMulSchoolbook(a, n, b, m, res);
+    return;
+  }
+
+  poly_coeff_t *chunk_res =
+    (poly_coeff_t *)safeMalloc((2 * n - 1) * sizeof(poly_coeff_t));
+  poly_coeff_t *scratch = (poly_coeff_t *)safeMalloc(
+    (KaratsubaScratchSize(n) + 1) * sizeof(poly_coeff_t));
+
+  for (size_t k = 0; k < n + m - 1; k++)
+    res[k] = 0;
+  for (size_t begin = 0; begin < m; begin += n) {
+    size_t len = m - begin < n ? m - begin : n;
+    if (len == n)
+      KaratsubaRec(a, b + begin, n, chunk_res, scratch);
+    else
+      DenseMulKaratsuba(a, n, b + begin, len, chunk_res);
+    for (size_t k = 0; k < n + len - 1; k++)
+      res[begin + k] = CoeffAdd(res[begin + k], chunk_res[k]);
+  }
+
+  free(chunk_res);
+  free(scratch);
+}
+
+/**
+ * Wylicza liczbę bitów potrzebnych do zapisania największej wartości
+ * bezwzględnej współczynnika.
+ * @param[in] a : współczynniki
+ * @param[in] n : liczba współczynników
+ * @return liczba bitów
+ */
+static int CoeffsBits(const poly_coeff_t a[], size_t n) {
+  uint64_t max_abs = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint64_t abs = a[i] < 0 ? -(uint64_t)a[i] : (uint64_t)a[i];
+    if (abs > max_abs)
+      max_abs = abs;
+  }
+  int bits = 0;
+  for (; max_abs > 0; max_abs >>= 1)
+    bits++;
+  return bits;
+}
+
+/**
+ * Wylicza, ile liczb pierwszych potrzeba do mnożenia gęstych wielomianów
+ * szybką transformatą. Jeśli wartości bezwzględne współczynników splotu
+ * mieszczą się w połowie iloczynu mniej niż NTT_NUM_OF_PRIMES liczb
+ * pierwszych, wystarczy liczyć splot liczb ze znakiem modulo te liczby.
+ * W przeciwnym przypadku współczynniki są traktowane jak liczby z przedziału
+ * @f$[0, 2^{64})@f$, bo wynik interesuje nas tylko modulo @f$2^{64}@f$,
+ * a NTT_NUM_OF_PRIMES liczb pierwszych wystarcza zawsze.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @return liczba liczb pierwszych
+ */
+static int NttNumOfPrimes(const poly_coeff_t a[], size_t n,
+                          const poly_coeff_t b[], size_t m) {
+  int bits = CoeffsBits(a, n) + CoeffsBits(b, m) + 1;
+  for (size_t len = n + m - 1; len > 0; len >>= 1)
+    bits++;
+  return bits < NTT_PRIME_BITS ? 1 :
+         bits < 2 * NTT_PRIME_BITS ? 2 : NTT_NUM_OF_PRIMES;
+}
+
+#ifdef __SIZEOF_INT128__
+
+/** To jest typ liczb 128-bitowych wykorzystywany przy mnożeniu modulo. */
+typedef unsigned __int128 ntt_wide_t;
+
+/** Największa potęga dwójki dzieląca @f$p - 1@f$ dla wszystkich liczb
+ * pierwszych, czyli logarytm największej długości transformaty. */
+#define NTT_MAX_LOG 40
+
+/**
+ * To jest struktura opisująca liczbę pierwszą, modulo którą liczona jest
+ * transformata. Liczby są przechowywane w postaci Montgomery'ego
+ * z @f$R = 2^{64}@f$.
+ */
+typedef struct NttPrime {
+  uint64_t p; ///< liczba pierwsza postaci @f$c \cdot 2^{40} + 1@f$, @f$p < 2^{62}@f$
+  uint64_t p_inv; ///< @f$-p^{-1} \bmod 2^{64}@f$
+  uint64_t r2; ///< @f$R^2 \bmod p@f$
+  uint64_t generator; ///< pierwiastek pierwotny modulo @f$p@f$
+} NttPrime;
+
+/**
+ * Liczby pierwsze, modulo które liczone są transformaty, wraz z ich
+ * pierwiastkami pierwotnymi. Iloczyn liczb przekracza @f$2^{185}@f$, więc
+ * wystarcza do odtworzenia dokładnej wartości każdego współczynnika splotu
+ * liczb z przedziału @f$[0, 2^{64})@f$.
+ */
+static const uint64_t ntt_primes[NTT_NUM_OF_PRIMES][2] = {
+  {4611615649683210241ULL, 11},
+  {4611613450659954689ULL, 3},
+  {4611549678985543681ULL, 19},
+};
+
+/**
+ * Mnoży modulo @f$p@f$ dwie liczby w postaci Montgomery'ego.
+ * @param[in] a : liczba @f$a < p@f$
+ * @param[in] b : liczba @f$b < p@f$
+ * @param[in] prime : liczba pierwsza
+ * @return @f$abR^{-1} \bmod p@f$
+ */
+static inline uint64_t MontMul(uint64_t a, uint64_t b, const NttPrime *prime) {
+  ntt_wide_t t = (ntt_wide_t)a * b;
+  uint64_t m = (uint64_t)t * prime->p_inv;
+  uint64_t u = (uint64_t)((t + (ntt_wide_t)m * prime->p) >> 64);
+  return u >= prime->p ? u - prime->p : u;
+}
+
+/**
+ * Podnosi do potęgi modulo @f$p@f$ liczbę w postaci Montgomery'ego.
+ * @param[in] base : podstawa
+ * @param[in] exp : wykładnik
+ * @param[in] prime : liczba pierwsza
+ * @return @f$base^{exp}@f$ w postaci Montgomery'ego
+ */
+static uint64_t MontPow(uint64_t base, uint64_t exp, const NttPrime *prime) {
+  uint64_t result = MontMul(1, prime->r2, prime);
+  while (exp > 0) {
+    if (exp % 2 == 1)
+      result = MontMul(result, base, prime);
+    base = MontMul(base, base, prime);
+    exp /= 2;
+  }
+  return result;
+}
+
+/**
+ * Wylicza stałe potrzebne do arytmetyki Montgomery'ego modulo @f$p@f$.
+ * @param[in] p : liczba pierwsza
+ * @param[in] generator : pierwiastek pierwotny modulo @f$p@f$
+ * @return opis liczby pierwszej
+ */
+static NttPrime NttPrimeNew(uint64_t p, uint64_t generator) {
+  NttPrime prime = {.p = p, .generator = generator};
+  // Metoda Newtona: każda iteracja podwaja liczbę poprawnych bitów odwrotności.
+  uint64_t inv = p;
+  for (int i = 0; i < 5; i++)
+    inv *= 2 - p * inv;
+  prime.p_inv = -inv;
+  uint64_t r = (-p) % p;
+  prime.r2 = (uint64_t)((ntt_wide_t)r * r % p);
+  return prime;
+}
+
+/**
+ * Wylicza w miejscu transformatę tablicy liczb w postaci Montgomery'ego.
+ * @param[in] a : tablica długości @p n
+ * @param[in] n : długość tablicy, potęga dwójki
+ * @param[in] roots : tablica pierwiastków z jedynki wypełniona przez NttRoots
+ * @param[in] prime : liczba pierwsza
+ */
+static void NttTransform(uint64_t a[], size_t n, const uint64_t roots[],
+                         const NttPrime *prime) {
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      uint64_t tmp = a[i];
+      a[i] = a[j];
+      a[j] = tmp;
+    }
+  }
+
+  uint64_t p = prime->p;
+  for (size_t half = 1; half < n; half <<= 1) {
+    const uint64_t *stage_roots = roots + half;
+    for (size_t i = 0; i < n; i += 2 * half) {
+      uint64_t *low = a + i, *high = a + i + half;
+      for (size_t j = 0; j < half; j++) {
+        uint64_t u = low[j];
+        uint64_t v = MontMul(high[j], stage_roots[j], prime);
+        low[j] = u + v >= p ? u + v - p : u + v;
+        high[j] = u >= v ? u - v : u + p - v;
+      }
+    }
+  }
+}
+
+/**
+ * Wypełnia tablicę pierwiastkami z jedynki potrzebnymi w kolejnych etapach
+ * transformaty. Etap łączący bloki długości @p half korzysta z potęg
+ * @f$w^0, w^1, \ldots, w^{half - 1}@f$ pierwiastka @f$w@f$ stopnia
+ * @f$2 \cdot half@f$, które są zapisane w komórkach od @p half do
+ * @f$2 \cdot half - 1@f$. Dzięki temu każdy etap czyta pierwiastki po kolei.
+ * @param[in] roots : tablica długości @p n
+ * @param[in] n : długość transformaty, potęga dwójki
+ * @param[in] inverse : czy brać odwrotności pierwiastków?
+ * @param[in] prime : liczba pierwsza
+ */
+static void NttRoots(uint64_t roots[], size_t n, bool inverse,
+                     const NttPrime *prime) {
+  uint64_t generator = MontMul(prime->generator, prime->r2, prime);
+  uint64_t one = MontMul(1, prime->r2, prime);
+  for (size_t half = 1; half < n; half <<= 1) {
+    uint64_t root = MontPow(generator, (prime->p - 1) / (2 * half), prime);
+    if (inverse)
+      root = MontPow(root, prime->p - 2, prime);
+    roots[half] = one;
+    for (size_t j = 1; j < half; j++)
+      roots[half + j] = MontMul(roots[half + j - 1], root, prime);
+  }
+}
+
+/**
+ * Mnoży modulo @f$p@f$ dwie liczby w zwykłej postaci.
+ * @param[in] a : liczba @f$a < p@f$
+ * @param[in] b : liczba @f$b < p@f$
+ * @param[in] p : liczba pierwsza
+ * @return @f$ab \bmod p@f$
+ */
+static uint64_t MulMod(uint64_t a, uint64_t b, uint64_t p) {
+  return (uint64_t)((ntt_wide_t)a * b % p);
+}
+
+/**
+ * Wylicza odwrotność modulo liczba pierwsza @f$p@f$.
+ * @param[in] a : liczba niepodzielna przez @f$p@f$
+ * @param[in] p : liczba pierwsza
+ * @return @f$a^{-1} \bmod p@f$
+ */
+static uint64_t InvMod(uint64_t a, uint64_t p) {
+  uint64_t result = 1, exp = p - 2;
+  a %= p;
+  while (exp > 0) {
+    if (exp % 2 == 1)
+      result = MulMod(result, a, p);
+    a = MulMod(a, a, p);
+    exp /= 2;
+  }
+  return result;
+}
+
+/**
+ * Sprowadza współczynnik do postaci Montgomery'ego modulo @f$p@f$.
+ * @param[in] c : współczynnik
+ * @param[in] is_signed : czy traktować współczynnik jako liczbę ze znakiem,
+ * a nie jako liczbę z przedziału @f$[0, 2^{64})@f$?
+ * @param[in] prime : liczba pierwsza
+ * @return współczynnik w postaci Montgomery'ego
+ */
+static uint64_t NttFromCoeff(poly_coeff_t c, bool is_signed,
+                             const NttPrime *prime) {
+  uint64_t residue;
+  if (is_signed && c < 0) {
+    residue = (-(uint64_t)c) % prime->p;
+    residue = residue == 0 ? 0 : prime->p - residue;
+  }
+  else {
+    residue = (uint64_t)c % prime->p;
+  }
+  return MontMul(residue, prime->r2, prime);
+}
+
+bool DenseMulNtt(const poly_coeff_t a[], size_t n,
+                 const poly_coeff_t b[], size_t m, poly_coeff_t res[]) {
+  size_t len = n + m - 1, size = 1;
+  while (size < len)
+    size <<= 1;
+  if (size > ((size_t)1 << NTT_MAX_LOG))
+    return false;
+
+  int num_of_primes = NttNumOfPrimes(a, n, b, m);
+  bool is_signed = num_of_primes < NTT_NUM_OF_PRIMES;
+
+  uint64_t *fa = (uint64_t *)safeMalloc(size * sizeof(uint64_t));
+  uint64_t *fb = (uint64_t *)safeMalloc(size * sizeof(uint64_t));
+  uint64_t *roots = (uint64_t *)safeMalloc(size * sizeof(uint64_t));
+  uint64_t *residues[NTT_NUM_OF_PRIMES];
+  NttPrime primes[NTT_NUM_OF_PRIMES];
+  for (int k = 0; k < NTT_NUM_OF_PRIMES; k++)
+    primes[k] = NttPrimeNew(ntt_primes[k][0], ntt_primes[k][1]);
+
+  for (int k = 0; k < num_of_primes; k++) {
+    const NttPrime *prime = &(primes[k]);
+
+    for (size_t i = 0; i < size; i++) {
+      fa[i] = i < n ? NttFromCoeff(a[i], is_signed, prime) : 0;
+      fb[i] = i < m ? NttFromCoeff(b[i], is_signed, prime) : 0;
+    }
+
+    NttRoots(roots, size, false, prime);
+    NttTransform(fa, size, roots, prime);
+    NttTransform(fb, size, roots, prime);
+    for (size_t i = 0; i < size; i++)
+      fa[i] = MontMul(fa[i], fb[i], prime);
+
+    NttRoots(roots, size, true, prime);
+    NttTransform(fa, size, roots, prime);
+    // Mnożenie przez n^{-1} łączymy z wyjściem z postaci Montgomery'ego.
+    uint64_t size_inv = InvMod(size, prime->p);
+    residues[k] = (uint64_t *)safeMalloc(len * sizeof(uint64_t));
+    for (size_t i = 0; i < len; i++)
+      residues[k][i] = MulMod(MontMul(fa[i], 1, prime), size_inv, prime->p);
+  }
+
+  // Chińskie twierdzenie o resztach w postaci Garnera:
+  // x = x_0 + x_1 p_0 + x_2 p_0 p_1, a wynik bierzemy modulo 2^64.
+  uint64_t p0 = primes[0].p, p1 = primes[1].p, p2 = primes[2].p;
+  if (num_of_primes == 1) {
+    for (size_t i = 0; i < len; i++) {
+      uint64_t x0 = residues[0][i];
+      res[i] = (poly_coeff_t)(x0 > p0 / 2 ? x0 - p0 : x0);
+    }
+  }
+  else if (num_of_primes == 2) {
+    uint64_t inv_p0_p1 = InvMod(p0, p1);
+    ntt_wide_t product = (ntt_wide_t)p0 * p1;
+    for (size_t i = 0; i < len; i++) {
+      uint64_t x0 = residues[0][i];
+      uint64_t x1 = MulMod((residues[1][i] + p1 - x0 % p1) % p1, inv_p0_p1, p1);
+      ntt_wide_t x = x0 + (ntt_wide_t)x1 * p0;
+      res[i] = (poly_coeff_t)(uint64_t)(x > product / 2 ? x - product : x);
+    }
+  }
+  else {
+    uint64_t inv_p0_p1 = InvMod(p0, p1), inv_p0_p2 = InvMod(p0, p2);
+    uint64_t inv_p1_p2 = InvMod(p1, p2);
+    for (size_t i = 0; i < len; i++) {
+      uint64_t x0 = residues[0][i];
+      uint64_t x1 = MulMod((residues[1][i] + p1 - x0 % p1) % p1, inv_p0_p1, p1);
+      uint64_t x2 = MulMod((residues[2][i] + p2 - x0 % p2) % p2, inv_p0_p2, p2);
+      x2 = MulMod((x2 + p2 - x1 % p2) % p2, inv_p1_p2, p2);
+      res[i] = (poly_coeff_t)(x0 + x1 * p0 + x2 * (p0 * p1));
+    }
+  }
+
+  for (int k = 0; k < num_of_primes; k++)
+    free(residues[k]);
+  free(fa);
+  free(fb);
+  free(roots);
+  return true;
+}
+
+#else
+
+bool DenseMulNtt(const poly_coeff_t a[], size_t n,
+                 const poly_coeff_t b[], size_t m, poly_coeff_t res[]) {
+  (void)a;
+  (void)n;
+  (void)b;
+  (void)m;
+  (void)res;
+  return false;
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+/**
+ * To jest struktura przechowująca jednomian wielomianu po podstawieniu
+ * Kroneckera, czyli niezerowy współczynnik i upakowany wykładnik.
+ */
+typedef struct KroneckerTerm {
+  uint64_t key; ///< upakowany wykładnik
+  poly_coeff_t coeff; ///< współczynnik
+} KroneckerTerm;
+
+/**
+ * To jest struktura opisująca podstawienie Kroneckera dla konkretnego iloczynu.
+ */
+typedef struct KroneckerLayout {
+  size_t num_of_vars; ///< liczba zmiennych
+  uint64_t *bound; ///< ograniczenia (stopień + 1) iloczynu względem zmiennych
+  uint64_t *stride; ///< wagi zmiennych w upakowanym wykładniku
+} KroneckerLayout;
+
+/**
+ * Liczy zmienne, od których zależy wielomian, czyli głębokość jego
+ * reprezentacji rekurencyjnej.
+ * @param[in] p : wielomian
+ * @return liczba zmiennych
+ */
+static size_t PolyNumOfVars(const Poly *p) {
+  size_t num_of_vars = 0;
+  if (!PolyIsCoeff(p)) {
+    Mono buffer;
+    const Mono *arr = PolyMonos(p, &buffer);
+    for (size_t i = 0; i < PolySize(p); i++) {
+      size_t num_of_vars_of_mono = PolyNumOfVars(&(arr[i].p)) + 1;
+      if (num_of_vars_of_mono > num_of_vars)
+        num_of_vars = num_of_vars_of_mono;
+    }
+  }
+  return num_of_vars;
+}
+
+/**
+ * Liczy jednomiany wielomianu w postaci rozwiniętej, czyli niezerowe
+ * współczynniki będące liczbami.
+ * @param[in] p : wielomian
+ * @return liczba jednomianów w postaci rozwiniętej
+ */
+static size_t PolyNumOfTerms(const Poly *p) {
+  if (PolyIsCoeff(p))
+    return PolyIsZero(p) ? 0 : 1;
+
+  Mono buffer;
+  const Mono *arr = PolyMonos(p, &buffer);
+  size_t count = 0;
+  for (size_t i = 0; i < PolySize(p); i++)
+    count += PolyNumOfTerms(&(arr[i].p));
+  return count;
+}
+
+/**
+ * Wyznacza podstawienie Kroneckera dla iloczynu @f$p * q@f$.
+ * Jeśli upakowany wykładnik nie mieści się w 64 bitach, zwraca false.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] layout : wyznaczone podstawienie
+ * @return czy podstawienie istnieje?
+ */
+static bool KroneckerLayoutNew(const Poly *p, const Poly *q,
+                               KroneckerLayout *layout) {
+  size_t p_vars = PolyNumOfVars(p), q_vars = PolyNumOfVars(q);
+  layout->num_of_vars = p_vars > q_vars ? p_vars : q_vars;
+  layout->bound = (uint64_t *)safeMalloc(layout->num_of_vars * sizeof(uint64_t));
+  layout->stride = (uint64_t *)safeMalloc(layout->num_of_vars * sizeof(uint64_t));
+
+  uint64_t total = 1;
+  for (size_t var = layout->num_of_vars; var-- > 0;) {
+    layout->bound[var] = (uint64_t)PolyDegBy(p, var) +
+                         (uint64_t)PolyDegBy(q, var) + 1;
+    layout->stride[var] = total;
+    if (layout->bound[var] > UINT64_MAX / total) {
+      free(layout->bound);
+      free(layout->stride);
+      return false;
+    }
+    total *= layout->bound[var];
+  }
+
+  return true;
+}
+
+/**
+ * Usuwa z pamięci podstawienie Kroneckera.
+ * @param[in] layout : podstawienie
+ */
+static void KroneckerLayoutDestroy(KroneckerLayout *layout) {
+  free(layout->bound);
+  free(layout->stride);
+}
+
+/**
+ * Upakowuje wielomian, dopisując jego jednomiany w postaci rozwiniętej do
+ * tablicy @p terms. Jednomiany są dopisywane w kolejności rosnących
+ * upakowanych wykładników.
+ * @param[in] p : wielomian nad zmienną @f$x_{var}@f$
+ * @param[in] layout : podstawienie
+ * @param[in] var : indeks zmiennej
+ * @param[in] key : upakowany wykładnik zmiennych o indeksach mniejszych niż
+ * @p var
+ * @param[in] terms : tablica jednomianów
+ * @param[in] count : wskaźnik na liczbę jednomianów w tablicy
+ */
+static void KroneckerPack(const Poly *p, const KroneckerLayout *layout,
+                          size_t var, uint64_t key, KroneckerTerm terms[],
+                          size_t *count) {
+  if (PolyIsCoeff(p)) {
+    if (!PolyIsZero(p))
+      terms[(*count)++] = (KroneckerTerm) {.key = key, .coeff = p->coeff};
+  }
+  else {
+    Mono buffer;
+    const Mono *arr = PolyMonos(p, &buffer);
+    for (size_t i = 0; i < PolySize(p); i++)
+      KroneckerPack(&(arr[i].p), layout, var + 1,
+                    key + (uint64_t)arr[i].exp * layout->stride[var],
+                    terms, count);
+  }
+}
+
+/**
+ * Rozpakowuje jednomiany o upakowanych wykładnikach, które mają wspólne
+ * wykładniki zmiennych o indeksach mniejszych niż @p var, do wielomianu nad
+ * zmienną @f$x_{var}@f$ w jednoznacznej, uporządkowanej postaci.
+ * @param[in] terms : niepusta tablica jednomianów posortowanych rosnąco po
+ * upakowanych wykładnikach
+ * @param[in] count : liczba jednomianów
+ * @param[in] layout : podstawienie
+ * @param[in] var : indeks zmiennej
+ * @return wielomian
+ */
+static Poly KroneckerUnpack(const KroneckerTerm terms[], size_t count,
+                            const KroneckerLayout *layout, size_t var) {
+  assert(count > 0);
+  if (var == layout->num_of_vars) {
+    assert(count == 1);
+    return PolyFromCoeff(terms[0].coeff);
+  }
+
+  uint64_t stride = layout->stride[var], bound = layout->bound[var];
+  size_t size = 0;
+  for (size_t i = 0; i < count; i++)
+    if (i == 0 || terms[i].key / stride != terms[i - 1].key / stride)
+      size++;
+
+  Mono *arr = PolyMonosAlloc(size);
+  size_t begin = 0;
+  for (size_t i = 0; i < size; i++) {
+    size_t end = begin + 1;
+    while (end < count && terms[end].key / stride == terms[begin].key / stride)
+      end++;
+    Poly p = KroneckerUnpack(terms + begin, end - begin, layout, var + 1);
+    arr[i] = MonoFromPoly(&p, (poly_exp_t)(terms[begin].key / stride % bound));
+    begin = end;
+  }
+
+  return PolyFromMonos(size, arr);
+}
+
+/**
+ * To jest struktura przechowująca element kopca wykorzystywanego przy mnożeniu
+ * wielomianów po podstawieniu Kroneckera.
+ */
+typedef struct KroneckerHeapEntry {
+  uint64_t key; ///< upakowany wykładnik iloczynu jednomianów
+  size_t row; ///< indeks jednomianu w pierwszym czynniku
+  size_t col; ///< indeks jednomianu w drugim czynniku
+} KroneckerHeapEntry;
+
+/**
+ * Przywraca własność kopca typu min, przesuwając element @p i w dół.
+ * @param[in] heap : kopiec
+ * @param[in] size : liczba elementów kopca
+ * @param[in] i : indeks przesuwanego elementu
+ */
+static void KroneckerHeapSiftDown(KroneckerHeapEntry heap[], size_t size,
+                                  size_t i) {
+  KroneckerHeapEntry entry = heap[i];
+  while (2 * i + 1 < size) {
+    size_t child = 2 * i + 1;
+    if (child + 1 < size && heap[child + 1].key < heap[child].key)
+      child++;
+    if (heap[child].key >= entry.key)
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = entry;
+}
+
+/**
+ * Mnoży dwa niepuste wielomiany jednej zmiennej o upakowanych wykładnikach
+ * algorytmem kopcowym. Jednomiany iloczynu powstają w kolejności rosnących
+ * wykładników, a jednomiany zerowe są pomijane.
+ * @param[in] a : jednomiany pierwszego czynnika
+ * @param[in] a_count : liczba jednomianów pierwszego czynnika
+ * @param[in] b : jednomiany drugiego czynnika
+ * @param[in] b_count : liczba jednomianów drugiego czynnika
+ * @param[out] prod : wskaźnik na zaalokowaną tablicę jednomianów iloczynu
+ * @return liczba jednomianów iloczynu
+ */
+static size_t KroneckerMulHeap(const KroneckerTerm a[], size_t a_count,
+                               const KroneckerTerm b[], size_t b_count,
+                               KroneckerTerm **prod) {
+  if (a_count > b_count) {
+    const KroneckerTerm *tmp = a;
+    a = b;
+    b = tmp;
+    size_t tmp_count = a_count;
+    a_count = b_count;
+    b_count = tmp_count;
+  }
+
+  size_t heap_size = a_count;
+  KroneckerHeapEntry *heap =
+    (KroneckerHeapEntry *)safeMalloc(heap_size * sizeof(KroneckerHeapEntry));
+  for (size_t i = 0; i < heap_size; i++)
+    heap[i] = (KroneckerHeapEntry) {.key = a[i].key + b[0].key,
+                                    .row = i, .col = 0};
+
+  size_t capacity = b_count, count = 0;
+  KroneckerTerm *arr =
+    (KroneckerTerm *)safeMalloc(capacity * sizeof(KroneckerTerm));
+  KroneckerTerm acc = {.key = heap[0].key, .coeff = 0};
+
+  while (heap_size > 0) {
+    KroneckerHeapEntry top = heap[0];
+    if (top.key != acc.key) {
+      if (acc.coeff != 0) {
+        if (count == capacity) {
+          capacity *= 2;
+          arr = (KroneckerTerm *)safeRealloc(arr,
+                                             capacity * sizeof(KroneckerTerm));
+        }
+        arr[count++] = acc;
+      }
+      acc = (KroneckerTerm) {.key = top.key, .coeff = 0};
+    }
+    acc.coeff = CoeffAdd(acc.coeff, CoeffMul(a[top.row].coeff,
+                                             b[top.col].coeff));
+
+    if (top.col + 1 < b_count) {
+      heap[0].col++;
+      heap[0].key = a[top.row].key + b[top.col + 1].key;
+    }
+    else {
+      heap[0] = heap[--heap_size];
+    }
+    KroneckerHeapSiftDown(heap, heap_size, 0);
+  }
+
+  if (acc.coeff != 0) {
+    if (count == capacity) {
+      capacity++;
+      arr = (KroneckerTerm *)safeRealloc(arr, capacity * sizeof(KroneckerTerm));
+    }
+    arr[count++] = acc;
+  }
+
+  free(heap);
+  *prod = arr;
+  return count;
+}
+
+/**
+ * Sprawdza, czy wielomian jednej zmiennej o upakowanych wykładnikach jest
+ * gęsty, czyli czy co najmniej połowa współczynników między najmniejszym
+ * a największym wykładnikiem jest niezerowa.
+ * @param[in] terms : jednomiany posortowane rosnąco po wykładnikach
+ * @param[in] count : liczba jednomianów
+ * @return czy wielomian jest gęsty?
+ */
+static bool KroneckerIsDense(const KroneckerTerm terms[], size_t count) {
+  return terms[count - 1].key - terms[0].key < 2 * (uint64_t)count;
+}
+
+/**
+ * Rozwija wielomian jednej zmiennej o upakowanych wykładnikach do tablicy
+ * współczynników przy kolejnych potęgach zmiennej, zaczynając od najmniejszego
+ * wykładnika.
+ * @param[in] terms : jednomiany posortowane rosnąco po wykładnikach
+ * @param[in] count : liczba jednomianów
+ * @param[out] len : liczba współczynników
+ * @return zaalokowana tablica współczynników
+ */
+static poly_coeff_t *KroneckerToDense(const KroneckerTerm terms[], size_t count,
+                                      size_t *len) {
+  *len = terms[count - 1].key - terms[0].key + 1;
+  poly_coeff_t *dense = (poly_coeff_t *)calloc(*len, sizeof(poly_coeff_t));
+  if (dense == NULL)
+    exit(1);
+  for (size_t i = 0; i < count; i++)
+    dense[terms[i].key - terms[0].key] = terms[i].coeff;
+  return dense;
+}
+
+/**
+ * Mnoży dwa niepuste, gęste wielomiany jednej zmiennej o upakowanych
+ * wykładnikach, rozwijając je do tablic współczynników.
+ * @param[in] a : jednomiany pierwszego czynnika
+ * @param[in] a_count : liczba jednomianów pierwszego czynnika
+ * @param[in] b : jednomiany drugiego czynnika
+ * @param[in] b_count : liczba jednomianów drugiego czynnika
+ * @param[out] prod : wskaźnik na zaalokowaną tablicę jednomianów iloczynu
+ * @return liczba jednomianów iloczynu
+ */
+static size_t KroneckerMulDense(const KroneckerTerm a[], size_t a_count,
+                                const KroneckerTerm b[], size_t b_count,
+                                KroneckerTerm **prod) {
+  size_t a_len, b_len;
+  poly_coeff_t *a_dense = KroneckerToDense(a, a_count, &a_len);
+  poly_coeff_t *b_dense = KroneckerToDense(b, b_count, &b_len);
+  size_t len = a_len + b_len - 1;
+  poly_coeff_t *dense = (poly_coeff_t *)safeMalloc(len * sizeof(poly_coeff_t));
+
+  size_t min_len = a_len < b_len ? a_len : b_len;
+  size_t num_of_primes = NttNumOfPrimes(a_dense, a_len, b_dense, b_len);
+  if (min_len < NTT_THRESHOLD * num_of_primes * num_of_primes ||
+      !DenseMulNtt(a_dense, a_len, b_dense, b_len, dense))
+    DenseMulKaratsuba(a_dense, a_len, b_dense, b_len, dense);
+  free(a_dense);
+  free(b_dense);
+
+  size_t count = 0;
+  for (size_t k = 0; k < len; k++)
+    if (dense[k] != 0)
+      count++;
+
+  KroneckerTerm *arr =
+    (KroneckerTerm *)safeMalloc((count > 0 ? count : 1) * sizeof(KroneckerTerm));
+  uint64_t shift = a[0].key + b[0].key;
+  count = 0;
+  for (size_t k = 0; k < len; k++)
+    if (dense[k] != 0)
+      arr[count++] = (KroneckerTerm) {.key = shift + k, .coeff = dense[k]};
+
+  free(dense);
+  *prod = arr;
+  return count;
+}
+
+bool PolyMulKronecker(const Poly *p, const Poly *q, Poly *prod) {
+  size_t p_count = PolyNumOfTerms(p), q_count = PolyNumOfTerms(q);
+  if (p_count == 0 || q_count == 0 ||
+      p_count * q_count < KRONECKER_MIN_PRODUCTS)
+    return false;
+
+  KroneckerLayout layout;
+  if (!KroneckerLayoutNew(p, q, &layout))
+    return false;
+
+  KroneckerTerm *p_terms =
+    (KroneckerTerm *)safeMalloc(p_count * sizeof(KroneckerTerm));
+  KroneckerTerm *q_terms =
+    (KroneckerTerm *)safeMalloc(q_count * sizeof(KroneckerTerm));
+  size_t p_packed = 0, q_packed = 0;
+  KroneckerPack(p, &layout, 0, 0, p_terms, &p_packed);
+  KroneckerPack(q, &layout, 0, 0, q_terms, &q_packed);
+  assert(p_packed == p_count && q_packed == q_count);
+
+  KroneckerTerm *prod_terms;
+  size_t prod_count;
+  if (KroneckerIsDense(p_terms, p_count) && KroneckerIsDense(q_terms, q_count))
+    prod_count = KroneckerMulDense(p_terms, p_count, q_terms, q_count,
+                                   &prod_terms);
+  else
+    prod_count = KroneckerMulHeap(p_terms, p_count, q_terms, q_count,
+                                  &prod_terms);
+  free(p_terms);
+  free(q_terms);
+
+  if (prod_count == 0)
+    *prod = PolyZero();
+  else
+    *prod = KroneckerUnpack(prod_terms, prod_count, &layout, 0);
+
+  free(prod_terms);
+  KroneckerLayoutDestroy(&layout);
+  return true;
+}
+
+/**
+ * Liczba wątków ustawiona przez PolyMulSetNumOfThreads albo 0, jeśli liczba
+ * wątków jest równa liczbie dostępnych procesorów.
+ */
+static size_t num_of_threads = 0;
+
+void PolyMulSetNumOfThreads(size_t n) {
+  num_of_threads = n;
+}
+
+size_t PolyMulGetNumOfThreads(void) {
+  if (num_of_threads > 0)
+    return num_of_threads;
+#if PARALLEL_ENABLED
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  return online > 1 ? (size_t)online : 1;
+#else
+  return 1;
+#endif
+}
+
+#if PARALLEL_ENABLED
+
+/**
+ * Czy bieżący wątek wykonuje już część mnożenia wielowątkowego? Mnożenia
+ * wywoływane wewnątrz takiej części są wykonywane w jednym wątku, aby liczba
+ * wątków nie rosła wykładniczo.
+ */
+static _Thread_local bool in_parallel_mul = false;
+
+/**
+ * To jest struktura opisująca zadanie jednego wątku: iloczyn bloku jednomianów
+ * jednego czynnika przez drugi czynnik albo sumę dwóch iloczynów częściowych.
+ */
+typedef struct ParallelTask {
+  Poly block; ///< blok kolejnych jednomianów dzielonego czynnika
+  const Poly *other; ///< drugi czynnik
+  Poly *res; ///< wynik, a przy sumowaniu także pierwszy składnik
+  Poly *addend; ///< drugi składnik albo NULL przy mnożeniu
+  pthread_t thread; ///< wątek wykonujący zadanie
+  bool is_started; ///< czy zadanie zostało przekazane osobnemu wątkowi?
+} ParallelTask;
+
+/**
+ * Wykonuje zadanie w bieżącym wątku.
+ * @param[in] arg : wskaźnik na zadanie
+ * @return NULL
+ */
+static void *ParallelTaskRun(void *arg) {
+  ParallelTask *task = (ParallelTask *)arg;
+  bool was_in_parallel_mul = in_parallel_mul;
+  in_parallel_mul = true;
+  if (task->addend == NULL)
+    *task->res = PolyMul(&(task->block), task->other);
+  else
+    *task->res = PolyAddOwn(task->res, task->addend);
+  in_parallel_mul = was_in_parallel_mul;
+  return NULL;
+}
+
+/**
+ * Wykonuje zadania współbieżnie. Pierwsze zadanie jest wykonywane przez
+ * bieżący wątek, a pozostałe przez nowe wątki. Jeśli wątku nie da się
+ * utworzyć, zadanie jest wykonywane przez bieżący wątek.
+ * @param[in,out] tasks : zadania
+ * @param[in] count : liczba zadań
+ */
+static void ParallelTasksRun(ParallelTask tasks[], size_t count) {
+  for (size_t i = 1; i < count; i++)
+    tasks[i].is_started = pthread_create(&(tasks[i].thread), NULL,
+                                         ParallelTaskRun, &(tasks[i])) == 0;
+  ParallelTaskRun(&(tasks[0]));
+  for (size_t i = 1; i < count; i++) {
+    if (tasks[i].is_started)
+      pthread_join(tasks[i].thread, NULL);
+    else
+      ParallelTaskRun(&(tasks[i]));
+  }
+}
+
+/**
+ * Tworzy wielomian z jednomianów pierwszego poziomu wielomianu o numerach
+ * z przedziału @f$[begin, end)@f$. Współczynniki jednomianów są kopiowane
+ * w czasie stałym.
+ * @param[in] p : wielomian przechowywany w tablicy
+ * @param[in] begin : początek przedziału
+ * @param[in] end : koniec przedziału większy od @p begin
+ * @return wielomian
+ */
+static Poly ParallelBlock(const Poly *p, size_t begin, size_t end) {
+  Mono *arr = PolyMonosAlloc(end - begin);
+  for (size_t i = begin; i < end; i++)
+    arr[i - begin] = MonoClone(&(p->arr[i]));
+  return PolyFromMonos(end - begin, arr);
+}
+
+bool PolyMulParallel(const Poly *p, const Poly *q, Poly *prod) {
+  // Jednomian przechowywany bez tablicy nie daje się podzielić na bloki.
+  if (in_parallel_mul || PolyIsCoeff(p) || PolyIsCoeff(q) ||
+      PolyIsInline(p) || PolyIsInline(q))
+    return false;
+
+  size_t threads = PolyMulGetNumOfThreads();
+  // Dzielony jest czynnik o większej liczbie jednomianów pierwszego poziomu.
+  if (p->size < q->size) {
+    const Poly *tmp = p;
+    p = q;
+    q = tmp;
+  }
+  if (threads > p->size)
+    threads = p->size;
+  if (threads < 2)
+    return false;
+
+  size_t p_count = PolyNumOfTerms(p), q_count = PolyNumOfTerms(q);
+  if (p_count * q_count < PARALLEL_MIN_PRODUCTS)
+    return false;
+
+  // Wątki nie widzą obszaru bieżącego wątku, więc wszystkie iloczyny
+  // częściowe powstają poza nim.
+  PolyArena *arena = PolyArenaSuspend();
+
+  // Jednomiany są dzielone na bloki o zbliżonej liczbie jednomianów
+  // w postaci rozwiniętej. Każdy blok jest osobnym wielomianem w jednoznacznej
+  // postaci, którego jednomiany współdzielą współczynniki z @p p.
+  ParallelTask *tasks =
+    (ParallelTask *)safeMalloc(threads * sizeof(ParallelTask));
+  Poly *results = (Poly *)safeMalloc(threads * sizeof(Poly));
+  size_t begin = 0, done = 0;
+  for (size_t t = 0; t < threads; t++) {
+    // Każdy z kolejnych bloków musi dostać co najmniej jeden jednomian.
+    size_t max_end = p->size - (threads - t - 1);
+    size_t target = t + 1 == threads ? p_count : p_count / threads * (t + 1);
+    size_t end = begin;
+    do {
+      done += PolyNumOfTerms(&(p->arr[end].p));
+      end++;
+    } while (end < max_end && done < target);
+    tasks[t] = (ParallelTask) {
+      .block = ParallelBlock(p, begin, end),
+      .other = q, .res = &(results[t]), .addend = NULL, .is_started = false
+    };
+    begin = end;
+  }
+  assert(begin == p->size);
+  ParallelTasksRun(tasks, threads);
+  for (size_t t = 0; t < threads; t++)
+    PolyDestroy(&(tasks[t].block));
+
+  // Iloczyny częściowe są posortowane, więc łączymy je parami, w każdej
+  // rundzie wszystkie pary współbieżnie.
+  for (size_t step = 1; step < threads; step *= 2) {
+    size_t count = 0;
+    for (size_t i = 0; i + step < threads; i += 2 * step)
+      tasks[count++] = (ParallelTask) {
+        .res = &(results[i]), .addend = &(results[i + step]),
+        .is_started = false
+      };
+    ParallelTasksRun(tasks, count);
+  }
+
+  PolyArenaResume(arena);
+  *prod = results[0];
+  free(tasks);
+  free(results);
+  return true;
+}
+
+#else
+
+bool PolyMulParallel(const Poly *p, const Poly *q, Poly *prod) {
+  (void)p;
+  (void)q;
+  (void)prod;
+  return false;
+}
+
+#endif /* PARALLEL_ENABLED */
@@ -0,0 +1,104 @@
+/** @file
+  Moduł udostępniający szybkie algorytmy mnożenia wielomianów wykorzystywane
+  przez funkcję PolyMul
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef POLYNOMIALS_POLY_MUL_H
+#define POLYNOMIALS_POLY_MUL_H
+
+#include <stdbool.h>
+
+#include "poly.h"
+
+/**
+ * Mnoży dwa wielomiany przez podstawienie Kroneckera. Wszystkie zmienne są
+ * upakowywane w jeden 64-bitowy wykładnik, w którym zmienna @f$x_i@f$ ma wagę
+ * równą iloczynowi ograniczeń stopni iloczynu względem zmiennych
+ * @f$x_{i+1}, x_{i+2}, \ldots@f$. Otrzymane wielomiany jednej zmiennej są
+ * mnożone jednokrotnie, a wynik jest rozpakowywany z powrotem do postaci
+ * rekurencyjnej. Jeśli upakowany wykładnik nie mieści się w 64 bitach albo
+ * iloczyn jest zbyt mały, żeby podstawienie się opłacało, zwraca false
+ * i nie modyfikuje @p prod.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] prod : wskaźnik na miejsce na iloczyn @f$p * q@f$
+ * @return czy iloczyn został wyliczony?
+ */
+bool PolyMulKronecker(const Poly *p, const Poly *q, Poly *prod);
+
+/**
+ * Mnoży dwa wielomiany, rozdzielając pracę między wątki. Czynnik o większej
+ * liczbie jednomianów pierwszego poziomu jest dzielony na bloki kolejnych
+ * jednomianów, każdy wątek mnoży jeden blok przez drugi czynnik, a posortowane
+ * iloczyny częściowe są łączone parami, również współbieżnie. Jeśli iloczyn
+ * jest zbyt mały, żeby podział się opłacał, dostępny jest tylko jeden wątek
+ * albo funkcja jest wywołana wewnątrz innego mnożenia wielowątkowego, zwraca
+ * false i nie modyfikuje @p prod.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] prod : wskaźnik na miejsce na iloczyn @f$p * q@f$
+ * @return czy iloczyn został wyliczony?
+ */
+bool PolyMulParallel(const Poly *p, const Poly *q, Poly *prod);
+
+/**
+ * Ustawia liczbę wątków wykorzystywanych przez PolyMulParallel. Nie może być
+ * wywoływana współbieżnie z mnożeniem.
+ * @param[in] n : liczba wątków albo 0, aby używać tylu wątków, ile jest
+ * dostępnych procesorów
+ */
+void PolyMulSetNumOfThreads(size_t n);
+
+/**
+ * Podaje liczbę wątków wykorzystywanych przez PolyMulParallel.
+ * @return liczba wątków
+ */
+size_t PolyMulGetNumOfThreads(void);
+
+/**
+ * Mnoży dwa gęste wielomiany jednej zmiennej algorytmem szkolnym. Wielomiany
+ * są zadane niepustymi tablicami współczynników przy kolejnych potęgach
+ * zmiennej. Działania są wykonywane modulo @f$2^{64}@f$, tak jak w PolyMul.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @param[out] res : tablica na @f$n + m - 1@f$ współczynników iloczynu
+ */
+void DenseMulSchoolbook(const poly_coeff_t a[], size_t n,
+                        const poly_coeff_t b[], size_t m, poly_coeff_t res[]);
+
+/**
+ * Mnoży dwa gęste wielomiany jednej zmiennej algorytmem Karatsuby. Dłuższy
+ * czynnik jest dzielony na kawałki długości krótszego. Wynik jest dokładnie
+ * taki sam jak w DenseMulSchoolbook.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @param[out] res : tablica na @f$n + m - 1@f$ współczynników iloczynu
+ */
+void DenseMulKaratsuba(const poly_coeff_t a[], size_t n,
+                       const poly_coeff_t b[], size_t m, poly_coeff_t res[]);
+
+/**
+ * Mnoży dwa gęste wielomiany jednej zmiennej szybką transformatą
+ * teoretyczno-liczbową. Splot jest liczony modulo trzy 62-bitowe liczby
+ * pierwsze, a współczynniki wyniku są odtwarzane z chińskiego twierdzenia
+ * o resztach. Wynik jest dokładnie taki sam jak w DenseMulSchoolbook.
+ * Jeśli kompilator nie udostępnia liczb 128-bitowych albo iloczyn jest zbyt
+ * długi, zwraca false i nie modyfikuje @p res.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : liczba współczynników drugiego czynnika
+ * @param[out] res : tablica na @f$n + m - 1@f$ współczynników iloczynu
+ * @return czy iloczyn został wyliczony?
+ */
+bool DenseMulNtt(const poly_coeff_t a[], size_t n,
+                 const poly_coeff_t b[], size_t m, poly_coeff_t res[]);
+
+#endif //POLYNOMIALS_POLY_MUL_H
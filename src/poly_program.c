@@ -0,0 +1,306 @@
+/** @file
+  Implementacja modułu udostępniającego wielomiany skompilowane do płaskiego
+  programu wyliczającego ich wartości
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#include <stdlib.h>
+
+#include "poly_alloc.h"
+#include "poly_program.h"
+#include "safe_functions.h"
+
+/**
+ * Komparator porównujący potęgi po zmiennych, a potem po wykładnikach,
+ * wykorzystywany przez qsort.
+ * @param[in] ptr1 : wskaźnik na potęgę
+ * @param[in] ptr2 : wskaźnik na potęgę
+ */
+static int ProgramPowerComp(const void *ptr1, const void *ptr2) {
+  const ProgramPower *a = (const ProgramPower *)ptr1;
+  const ProgramPower *b = (const ProgramPower *)ptr2;
+
+  if (a->var != b->var)
+    return a->var < b->var ? -1 : 1;
+  else if (a->exp != b->exp)
+    return a->exp < b->exp ? -1 : 1;
+  else
+    return 0;
+}
+
+/**
+ * Dopisuje potęgę do tablicy potęg programu, powiększając ją w razie potrzeby.
+ * @param[in,out] program : program
+ * @param[in,out] capacity : rozmiar tablicy @p program->powers
+ * @param[in] var : numer zmiennej
+ * @param[in] exp : dodatni wykładnik
+ */
+static void ProgramAddPower(PolyProgram *program, size_t *capacity,
+                            size_t var, poly_exp_t exp) {
+  if (program->num_of_powers == *capacity) {
+    *capacity = 2 * *capacity + 1;
+    program->powers = (ProgramPower *)safeRealloc(program->powers,
+      *capacity * sizeof(ProgramPower));
+  }
+  program->powers[program->num_of_powers++] =
+    (ProgramPower) {.var = var, .exp = exp};
+}
+
+/**
+ * Zbiera potęgi zmiennych, przez które mnoży schemat Hornera dla wielomianu:
+ * różnice kolejnych wykładników i najmniejszy wykładnik na każdym poziomie.
+ * Wyznacza też liczbę zmiennych, od których zależy wielomian.
+ * @param[in,out] program : program
+ * @param[in,out] capacity : rozmiar tablicy @p program->powers
+ * @param[in] p : wielomian
+ * @param[in] var : numer zmiennej pierwszego poziomu @p p
+ */
+static void ProgramCollectPowers(PolyProgram *program, size_t *capacity,
+                                 const Poly *p, size_t var) {
+  if (PolyIsCoeff(p))
+    return;
+
+  Mono mono_buffer;
+  const Mono *arr = PolyMonos(p, &mono_buffer);
+  if (var + 1 > program->num_of_vars)
+    program->num_of_vars = var + 1;
+  if (arr[0].exp > 0)
+    ProgramAddPower(program, capacity, var, arr[0].exp);
+  for (size_t i = 0; i < PolySize(p); i++) {
+    if (i > 0)
+      ProgramAddPower(program, capacity, var, arr[i].exp - arr[i - 1].exp);
+    ProgramCollectPowers(program, capacity, &(arr[i].p), var + 1);
+  }
+}
+
+/**
+ * Wyszukuje numer potęgi w posortowanej tablicy potęg programu.
+ * @param[in] program : program
+ * @param[in] var : numer zmiennej
+ * @param[in] exp : dodatni wykładnik
+ * @return numer potęgi @f$x_{var}^{exp}@f$
+ */
+static unsigned int ProgramPowerReg(const PolyProgram *program, size_t var,
+                                    poly_exp_t exp) {
+  ProgramPower key = {.var = var, .exp = exp};
+  const ProgramPower *found = bsearch(&key, program->powers,
+                                      program->num_of_powers,
+                                      sizeof(ProgramPower), ProgramPowerComp);
+  assert(found != NULL);
+  return (unsigned int)(found - program->powers);
+}
+
+/**
+ * Dopisuje instrukcję na koniec programu, powiększając go w razie potrzeby.
+ * @param[in,out] program : program
+ * @param[in,out] capacity : rozmiar tablicy @p program->code
+ * @param[in] op : kod instrukcji
+ * @param[in] reg : numer potęgi
+ * @param[in] value : liczba
+ */
+static void ProgramEmit(PolyProgram *program, size_t *capacity, ProgramOp op,
+                        unsigned int reg, poly_coeff_t value) {
+  if (program->code_size == *capacity) {
+    *capacity = 2 * *capacity + 1;
+    program->code = (ProgramInstr *)safeRealloc(program->code,
+      *capacity * sizeof(ProgramInstr));
+  }
+  program->code[program->code_size++] =
+    (ProgramInstr) {.op = op, .reg = reg, .value = value};
+}
+
+/**
+ * Generuje instrukcje wkładające na stos wartość wielomianu.
+ * @param[in,out] program : program
+ * @param[in,out] capacity : rozmiar tablicy @p program->code
+ * @param[in] p : wielomian
+ * @param[in] var : numer zmiennej pierwszego poziomu @p p
+ * @param[in] depth : głębokość stosu przed wykonaniem instrukcji
+ */
+static void ProgramCompileRec(PolyProgram *program, size_t *capacity,
+                              const Poly *p, size_t var, size_t depth) {
+  if (depth + 1 > program->stack_size)
+    program->stack_size = depth + 1;
+
+  if (PolyIsCoeff(p)) {
+    ProgramEmit(program, capacity, PROGRAM_CONST, 0, p->coeff);
+    return;
+  }
+
+  // Schemat Hornera po różnicach kolejnych wykładników, jak w PolyEval.
+  // Współczynniki liczbowe są dodawane jedną instrukcją razem z mnożeniem.
+  Mono mono_buffer;
+  const Mono *arr = PolyMonos(p, &mono_buffer);
+  size_t i = PolySize(p) - 1;
+  ProgramCompileRec(program, capacity, &(arr[i].p), var + 1, depth);
+  while (i > 0) {
+    unsigned int reg = ProgramPowerReg(program, var,
+                                       arr[i].exp - arr[i - 1].exp);
+    i--;
+    if (PolyIsCoeff(&(arr[i].p))) {
+      ProgramEmit(program, capacity, PROGRAM_MULADDC, reg, arr[i].p.coeff);
+    }
+    else {
+      ProgramCompileRec(program, capacity, &(arr[i].p), var + 1, depth + 1);
+      ProgramEmit(program, capacity, PROGRAM_MULADD, reg, 0);
+    }
+  }
+  if (arr[0].exp > 0)
+    ProgramEmit(program, capacity, PROGRAM_MUL,
+                ProgramPowerReg(program, var, arr[0].exp), 0);
+}
+
+PolyProgram PolyProgramNew(const Poly *p) {
+  PolyProgram program = {.num_of_vars = 0, .powers = NULL,
+                         .num_of_powers = 0, .code = NULL, .code_size = 0,
+                         .stack_size = 0, .memory = NULL};
+
+  size_t capacity = 0;
+  ProgramCollectPowers(&program, &capacity, p, 0);
+  // Usunięcie powtórzeń, aby każda potęga była wyliczana tylko raz.
+  if (program.num_of_powers > 0) {
+    qsort(program.powers, program.num_of_powers, sizeof(ProgramPower),
+          ProgramPowerComp);
+    size_t unique = 1;
+    for (size_t i = 1; i < program.num_of_powers; i++)
+      if (ProgramPowerComp(&(program.powers[i]),
+                           &(program.powers[unique - 1])) != 0)
+        program.powers[unique++] = program.powers[i];
+    program.num_of_powers = unique;
+  }
+
+  capacity = 0;
+  ProgramCompileRec(&program, &capacity, p, 0, 0);
+  ProgramEmit(&program, &capacity, PROGRAM_RET, 0, 0);
+
+  program.memory = (unsigned long *)safeMalloc(
+    (program.num_of_vars + program.num_of_powers + program.stack_size) *
+    sizeof(unsigned long));
+  return program;
+}
+
+void PolyProgramDestroy(PolyProgram *program) {
+  free(program->powers);
+  free(program->code);
+  free(program->memory);
+}
+
+/**
+ * Podnosi liczbę do potęgi modulo @f$2^{64}@f$.
+ * @param[in] base : podstawa
+ * @param[in] exp : wykładnik
+ * @return @f$base^{exp}@f$
+ */
+static unsigned long UnsignedPower(unsigned long base, poly_exp_t exp) {
+  unsigned long result = 1;
+  while (exp > 0) {
+    if (exp % 2 == 1)
+      result *= base;
+    base *= base;
+    exp /= 2;
+  }
+  return result;
+}
+
+/**
+ * Interpreter skacze do instrukcji przez tablicę adresów etykiet, jeśli
+ * kompilator udostępnia to rozszerzenie GNU. Opcja POLY_PROGRAM_SWITCH
+ * wymusza przenośną pętlę z instrukcją switch.
+ */
+#if defined(__GNUC__) && !defined(POLY_PROGRAM_SWITCH)
+#define PROGRAM_COMPUTED_GOTO 1
+#else
+#define PROGRAM_COMPUTED_GOTO 0
+#endif
+
+#if PROGRAM_COMPUTED_GOTO
+/**
+ * Przechodzi do następnej instrukcji. Każda instrukcja kończy się osobnym
+ * skokiem pośrednim, więc procesor przewiduje skoki osobno dla każdej
+ * instrukcji, a nie dla jednej wspólnej instrukcji switch.
+ */
+#define PROGRAM_NEXT goto *dispatch[instr->op]
+/** Etykieta instrukcji o podanym kodzie. */
+#define PROGRAM_CASE(op) op_##op:
+/** Początek pętli interpretera. */
+#define PROGRAM_LOOP_BEGIN PROGRAM_NEXT;
+/** Koniec pętli interpretera. */
+#define PROGRAM_LOOP_END
+#else
+/** Przechodzi do następnej instrukcji. */
+#define PROGRAM_NEXT continue
+/** Etykieta instrukcji o podanym kodzie. */
+#define PROGRAM_CASE(op) case op:
+/** Początek pętli interpretera. */
+#define PROGRAM_LOOP_BEGIN for (;;) switch (instr->op) {
+/** Koniec pętli interpretera. */
+#define PROGRAM_LOOP_END }
+#endif
+
+unsigned long *PolyProgramLoad(PolyProgram *program, size_t k,
+                               const poly_coeff_t x[]) {
+  unsigned long *xs = program->memory;
+  unsigned long *regs = xs + program->num_of_vars;
+
+  for (size_t i = 0; i < program->num_of_vars; i++)
+    xs[i] = i < k ? (unsigned long)x[i] : 0;
+
+  // Potęgi tej samej zmiennej są posortowane, więc każdą wyliczamy
+  // z poprzedniej.
+  for (size_t i = 0; i < program->num_of_powers; i++) {
+    const ProgramPower *power = &(program->powers[i]);
+    if (i > 0 && program->powers[i - 1].var == power->var)
+      regs[i] = regs[i - 1] * UnsignedPower(xs[power->var],
+        power->exp - program->powers[i - 1].exp);
+    else
+      regs[i] = UnsignedPower(xs[power->var], power->exp);
+  }
+  return regs;
+}
+
+poly_coeff_t PolyProgramEval(PolyProgram *program, size_t k,
+                             const poly_coeff_t x[]) {
+  unsigned long *regs = PolyProgramLoad(program, k, x);
+  unsigned long *top = regs + program->num_of_powers; // pierwsze wolne miejsce
+
+#if PROGRAM_COMPUTED_GOTO
+  // Rozszerzenie jest zamierzone, więc nie ostrzegamy o nim przy -pedantic.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+  static const void *const dispatch[] = {
+    [PROGRAM_CONST] = &&op_PROGRAM_CONST,
+    [PROGRAM_MUL] = &&op_PROGRAM_MUL,
+    [PROGRAM_MULADDC] = &&op_PROGRAM_MULADDC,
+    [PROGRAM_MULADD] = &&op_PROGRAM_MULADD,
+    [PROGRAM_RET] = &&op_PROGRAM_RET
+  };
+#endif
+
+  const ProgramInstr *instr = program->code;
+  PROGRAM_LOOP_BEGIN
+  PROGRAM_CASE(PROGRAM_CONST)
+    *top++ = (unsigned long)instr->value;
+    instr++;
+    PROGRAM_NEXT;
+  PROGRAM_CASE(PROGRAM_MUL)
+    top[-1] *= regs[instr->reg];
+    instr++;
+    PROGRAM_NEXT;
+  PROGRAM_CASE(PROGRAM_MULADDC)
+    top[-1] = top[-1] * regs[instr->reg] + (unsigned long)instr->value;
+    instr++;
+    PROGRAM_NEXT;
+  PROGRAM_CASE(PROGRAM_MULADD)
+    top--;
+    top[-1] = top[-1] * regs[instr->reg] + top[0];
+    instr++;
+    PROGRAM_NEXT;
+  PROGRAM_CASE(PROGRAM_RET)
+    return (poly_coeff_t)top[-1];
+  PROGRAM_LOOP_END
+#if PROGRAM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+}
@@ -0,0 +1,97 @@
+/** @file
+  Moduł udostępniający wielomiany skompilowane do płaskiego programu
+  wyliczającego ich wartości
+
+  Skompilowany wielomian jest ciągiem instrukcji prostej maszyny stosowej
+  realizującej wielowymiarowy schemat Hornera. Potęgi zmiennych potrzebne
+  w schemacie Hornera są wyliczane raz na początku każdego wykonania programu
+  i współdzielone przez wszystkie instrukcje.
+
+  @authors Patryk Jędrzejczak <pj429285@students.mimuw.edu.pl>
+  @date 2021
+*/
+
+#ifndef POLYNOMIALS_POLY_PROGRAM_H
+#define POLYNOMIALS_POLY_PROGRAM_H
+
+#include "poly.h"
+
+/** To jest typ wyliczeniowy reprezentujący kody instrukcji programu. */
+typedef enum ProgramOp {
+  PROGRAM_CONST, ///< wkłada na stos liczbę @p value
+  PROGRAM_MUL, ///< mnoży szczyt stosu przez potęgę @p reg
+  PROGRAM_MULADDC, ///< mnoży szczyt stosu przez potęgę @p reg i dodaje @p value
+  PROGRAM_MULADD, ///< zdejmuje b, mnoży szczyt przez potęgę @p reg i dodaje b
+  PROGRAM_RET ///< kończy program, zwracając szczyt stosu
+} ProgramOp;
+
+/**
+ * To jest struktura przechowująca instrukcję programu.
+ */
+typedef struct ProgramInstr {
+  ProgramOp op; ///< kod instrukcji
+  unsigned int reg; ///< numer potęgi, przez którą mnoży instrukcja
+  poly_coeff_t value; ///< liczba, którą wkłada lub dodaje instrukcja
+} ProgramInstr;
+
+/**
+ * To jest struktura opisująca potęgę zmiennej wyliczaną na początku programu.
+ */
+typedef struct ProgramPower {
+  size_t var; ///< numer zmiennej
+  poly_exp_t exp; ///< dodatni wykładnik
+} ProgramPower;
+
+/**
+ * To jest struktura przechowująca skompilowany wielomian.
+ */
+typedef struct PolyProgram {
+  size_t num_of_vars; ///< liczba zmiennych, od których zależy program
+  ProgramPower *powers; ///< potęgi posortowane po zmiennych i wykładnikach
+  size_t num_of_powers; ///< rozmiar tablicy @p powers
+  ProgramInstr *code; ///< instrukcje programu
+  size_t code_size; ///< liczba instrukcji programu
+  size_t stack_size; ///< największa głębokość stosu w trakcie wykonania
+  /** pamięć robocza na wartości zmiennych, potęgi i stos */
+  unsigned long *memory;
+} PolyProgram;
+
+/**
+ * Kompiluje wielomian do programu wyliczającego jego wartości.
+ * @param[in] p : wielomian
+ * @return skompilowany wielomian
+ */
+PolyProgram PolyProgramNew(const Poly *p);
+
+/**
+ * Usuwa z pamięci skompilowany wielomian.
+ * @param[in] program : skompilowany wielomian
+ */
+void PolyProgramDestroy(PolyProgram *program);
+
+/**
+ * Przygotowuje pamięć roboczą programu do wykonania instrukcji w punkcie
+ * @f$(x_0, x_1, \ldots, x_{k-1})@f$: zapisuje wartości zmiennych i wylicza
+ * wszystkie potęgi z tablicy @p program->powers. Bezpośrednio za potęgami
+ * znajduje się miejsce na @p program->stack_size wartości stosu.
+ * @param[in] program : skompilowany wielomian
+ * @param[in] k : rozmiar tablicy @p x
+ * @param[in] x : wartości kolejnych zmiennych
+ * @return tablica wyliczonych potęg w kolejności @p program->powers
+ */
+unsigned long *PolyProgramLoad(PolyProgram *program, size_t k,
+                               const poly_coeff_t x[]);
+
+/**
+ * Wylicza wartość skompilowanego wielomianu w punkcie
+ * @f$(x_0, x_1, \ldots, x_{k-1})@f$, tak jak PolyEval. Korzysta z pamięci
+ * roboczej programu, więc jeden program nie może być wykonywany współbieżnie.
+ * @param[in] program : skompilowany wielomian
+ * @param[in] k : rozmiar tablicy @p x
+ * @param[in] x : wartości kolejnych zmiennych
+ * @return wartość wielomianu
+ */
+poly_coeff_t PolyProgramEval(PolyProgram *program, size_t k,
+                             const poly_coeff_t x[]);
+
+#endif //POLYNOMIALS_POLY_PROGRAM_H
@@ -15,6 +15,7 @@ PolyStack PolyStackNew() {
   poly_stack.polys = (Poly *)safeMalloc(sizeof(Poly));
   poly_stack.polys_size = 1;
   poly_stack.num_of_polys = 0;
+  poly_stack.is_compiled = false;
   return poly_stack;
 }
 
@@ -36,6 +37,19 @@ void PolyStackPush(PolyStack *poly_stack, Poly p) {
   poly_stack->num_of_polys++;
 }
 
+/**
+ * Usuwa skompilowany program, jeśli dotyczy wielomianu na szczycie stosu,
+ * który właśnie jest zdejmowany.
+ * @param[in] poly_stack : wskaźnik na stos wielomianów
+ */
+static void PolyStackForgetTopProgram(PolyStack *poly_stack) {
+  if (poly_stack->is_compiled &&
+      poly_stack->compiled_index == poly_stack->num_of_polys - 1) {
+    PolyProgramDestroy(&(poly_stack->program));
+    poly_stack->is_compiled = false;
+  }
+}
+
 /**
  * Zwraca wielomian znajdujący się na szczycie stosu.
  * @param[in] poly_stack : wskaźnik na stos wielomianów
@@ -56,6 +70,19 @@ static Poly *PolyStackSecondTop(const PolyStack *poly_stack) {
   return poly_stack->polys + (poly_stack->num_of_polys - 2);
 }
 
+/**
+ * Zdejmuje wielomian ze szczytu stosu bez usuwania go z pamięci i przekazuje
+ * go na własność wywołującemu.
+ * @param[in] poly_stack : wskaźnik na stos wielomianów
+ * @return wielomian
+ */
+static Poly PolyStackTakeTop(PolyStack *poly_stack) {
+  Poly top = *PolyStackTop(poly_stack);
+  PolyStackForgetTopProgram(poly_stack);
+  poly_stack->num_of_polys--;
+  return top;
+}
+
 /**
  * Sprawdza czy stos wielomianów jest pusty.
  * @param[in] poly_stack : wskaźnik na stos wielomianów
@@ -97,11 +124,9 @@ bool PolyStackClone(PolyStack *poly_stack) {
 
 bool PolyStackAdd(PolyStack *poly_stack) {
   if (poly_stack->num_of_polys >= 2) {
-    Poly new_top = PolyAdd(PolyStackTop(poly_stack),
-                           PolyStackSecondTop(poly_stack));
-    PolyStackPop(poly_stack);
-    PolyStackPop(poly_stack);
-    PolyStackPush(poly_stack, new_top);
+    Poly top = PolyStackTakeTop(poly_stack);
+    Poly second_top = PolyStackTakeTop(poly_stack);
+    PolyStackPush(poly_stack, PolyAddOwn(&top, &second_top));
     return true;
   }
   return false;
@@ -109,11 +134,9 @@ bool PolyStackAdd(PolyStack *poly_stack) {
 
 bool PolyStackMul(PolyStack *poly_stack) {
   if (poly_stack->num_of_polys >= 2) {
-    Poly new_top = PolyMul(PolyStackTop(poly_stack),
-                           PolyStackSecondTop(poly_stack));
-    PolyStackPop(poly_stack);
-    PolyStackPop(poly_stack);
-    PolyStackPush(poly_stack, new_top);
+    Poly top = PolyStackTakeTop(poly_stack);
+    Poly second_top = PolyStackTakeTop(poly_stack);
+    PolyStackPush(poly_stack, PolyMulOwn(&top, &second_top));
     return true;
   }
   return false;
@@ -121,20 +144,17 @@ bool PolyStackMul(PolyStack *poly_stack) {
 
 bool PolyStackNeg(PolyStack *poly_stack) {
   if (!PolyStackIsEmpty(poly_stack)) {
-    Poly new_top = PolyNeg(PolyStackTop(poly_stack));
-    PolyStackPop(poly_stack);
-    PolyStackPush(poly_stack, new_top);
+    Poly top = PolyStackTakeTop(poly_stack);
+    PolyStackPush(poly_stack, PolyNegOwn(&top));
   }
   return !PolyStackIsEmpty(poly_stack);
 }
 
 bool PolyStackSub(PolyStack *poly_stack) {
   if (poly_stack->num_of_polys >= 2) {
-    Poly new_top = PolySub(PolyStackTop(poly_stack),
-                           PolyStackSecondTop(poly_stack));
-    PolyStackPop(poly_stack);
-    PolyStackPop(poly_stack);
-    PolyStackPush(poly_stack, new_top);
+    Poly top = PolyStackTakeTop(poly_stack);
+    Poly second_top = PolyStackTakeTop(poly_stack);
+    PolyStackPush(poly_stack, PolySubOwn(&top, &second_top));
     return true;
   }
   return false;
@@ -176,6 +196,30 @@ bool PolyStackAt(PolyStack *poly_stack, long long x) {
   return !PolyStackIsEmpty(poly_stack);
 }
 
+bool PolyStackCompile(PolyStack *poly_stack) {
+  if (!PolyStackIsEmpty(poly_stack)) {
+    if (poly_stack->is_compiled)
+      PolyProgramDestroy(&(poly_stack->program));
+    poly_stack->program = PolyProgramNew(PolyStackTop(poly_stack));
+    poly_stack->compiled_index = poly_stack->num_of_polys - 1;
+    poly_stack->is_compiled = true;
+  }
+  return !PolyStackIsEmpty(poly_stack);
+}
+
+bool PolyStackEval(PolyStack *poly_stack, size_t k,
+                   const poly_coeff_t x[]) {
+  if (!PolyStackIsEmpty(poly_stack)) {
+    if (poly_stack->is_compiled &&
+        poly_stack->compiled_index == poly_stack->num_of_polys - 1)
+      safePrintLong(PolyProgramEval(&(poly_stack->program), k, x));
+    else
+      safePrintLong(PolyEval(PolyStackTop(poly_stack), k, x));
+    safePrintChar('\n');
+  }
+  return !PolyStackIsEmpty(poly_stack);
+}
+
 bool PolyStackPrint(const PolyStack *poly_stack) {
   if (!PolyStackIsEmpty(poly_stack)) {
     PolyPrint(PolyStackTop(poly_stack));
@@ -187,6 +231,7 @@ bool PolyStackPrint(const PolyStack *poly_stack) {
 bool PolyStackPop(PolyStack *poly_stack) {
   if (!PolyStackIsEmpty(poly_stack)) {
     PolyDestroy(PolyStackTop(poly_stack));
+    PolyStackForgetTopProgram(poly_stack);
     poly_stack->num_of_polys--;
     return true;
   }
@@ -210,7 +255,22 @@ bool PolyStackCompose(PolyStack *poly_stack, size_t k) {
   }
 }
 
-
-
-
-
+bool PolyStackComposeBatch(PolyStack *poly_stack, size_t n, size_t k) {
+  assert(n > 0);
+  if (poly_stack->num_of_polys < n || poly_stack->num_of_polys - n < k) {
+    return false;
+  }
+  else {
+    Poly *p = poly_stack->polys + (poly_stack->num_of_polys - n);
+    PolyComposer composer = PolyComposerNew(k, p - k);
+    Poly *results = (Poly *)safeMalloc(n * sizeof(Poly));
+    PolyComposerApplyBatch(&composer, n, p, results);
+    PolyComposerDestroy(&composer);
+    for (size_t i = 0; i < n + k; i++)
+      PolyStackPop(poly_stack);
+    for (size_t i = 0; i < n; i++)
+      PolyStackPush(poly_stack, results[i]);
+    free(results);
+    return true;
+  }
+}
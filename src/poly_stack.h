@@ -9,6 +9,7 @@
 #define POLYNOMIALS_POLY_STACK_H
 
 #include "poly.h"
+#include "poly_program.h"
 
 /**
  * To jest struktura reprezentująca stos wielomianów.
@@ -17,6 +18,10 @@ typedef struct PolyStack {
   Poly *polys; ///< dynamiczna tablica reprezentująca stos wielomianów
   size_t polys_size; ///< rozmiar tablicy @p polys
   unsigned int num_of_polys; ///< liczba wielomianów na stosie
+  /** czy któryś z wielomianów na stosie jest skompilowany? */
+  bool is_compiled;
+  unsigned int compiled_index; ///< indeks skompilowanego wielomianu
+  PolyProgram program; ///< skompilowany wielomian
 } PolyStack;
 
 /**
@@ -143,6 +148,30 @@ bool PolyStackDegBy(const PolyStack *poly_stack, unsigned long long idx);
  */
 bool PolyStackAt(PolyStack *poly_stack, long long x);
 
+/**
+ * Kompiluje wielomian na szczycie stosu, aby kolejne wywołania PolyStackEval
+ * wyliczały jego wartości szybciej. Skompilowany program jest usuwany, gdy
+ * wielomian zostaje zdjęty ze stosu, a poprzednio skompilowany wielomian
+ * przestaje być skompilowany. Jeśli stos jest pusty i nie da się wykonać
+ * operacji, zwraca false.
+ * @param[in] poly_stack : wskaźnik na stos wielomianów
+ * @return czy stos nie jest pusty?
+ */
+bool PolyStackCompile(PolyStack *poly_stack);
+
+/**
+ * Wypisuje na standardowe wyjście wartość wielomianu na szczycie stosu
+ * w punkcie @f$(x_0, x_1, \ldots, x_{k-1})@f$. Nie zdejmuje wielomianu ze
+ * stosu. Jeśli wielomian jest skompilowany, wykonuje skompilowany program.
+ * Jeśli stos jest pusty i nie da się wykonać operacji, zwraca false.
+ * @param[in] poly_stack : wskaźnik na stos wielomianów
+ * @param[in] k : rozmiar tablicy @p x
+ * @param[in] x : wartości kolejnych zmiennych
+ * @return czy stos nie jest pusty?
+ */
+bool PolyStackEval(PolyStack *poly_stack, size_t k,
+                   const poly_coeff_t x[]);
+
 /**
  * Wypisuje na standardowe wyjście wielomian ze szczytu stosu. Jeśli stos jest
  * pusty i nie da się wykonać operacji, zwraca false.
@@ -171,4 +200,20 @@ bool PolyStackPop(PolyStack *poly_stack);
  */
 bool PolyStackCompose(PolyStack *poly_stack, size_t k);
 
+/**
+ * Wylicza złożenia @f$p_j(q_0, q_1, \ldots, q_{k-1})@f$ dla @f$n@f$
+ * wielomianów @f$p_j@f$ leżących na szczycie stosu, gdzie @f$q_i@f$ jest
+ * wielomianem znajdującym się na stosie @f$k - i@f$ pozycji niżej niż
+ * najgłębiej leżący z wielomianów @f$p_j@f$. Zdejmuje ze stosu wszystkie te
+ * wielomiany i umieszcza na nim wyniki złożeń w tej samej kolejności, w jakiej
+ * leżały wielomiany @f$p_j@f$. Potęgi wielomianów @f$q_i@f$ są wyliczane
+ * jednokrotnie dla wszystkich złożeń. Jeśli na stosie jest mniej niż
+ * @f$n + k@f$ wielomianów i nie da sie wykonać operacji, zwraca false.
+ * @param[in] poly_stack : wskaźnik na stos wielomianów
+ * @param[in] n : dodatnia ilość składanych wielomianów
+ * @param[in] k : ilość wielomianów podstawianych za zmienne
+ * @return czy na stosie jest przynajmniej @f$n + k@f$ wielomianów?
+ */
+bool PolyStackComposeBatch(PolyStack *poly_stack, size_t n, size_t k);
+
 #endif //POLYNOMIALS_POLY_STACK_H
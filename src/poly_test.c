@@ -3,10 +3,17 @@
 #endif
 
 #include "poly.h"
+#include "poly_alloc.h"
+#include "poly_dist.h"
+#include "poly_intern.h"
+#include "poly_jit.h"
+#include "poly_mul.h"
+#include "poly_program.h"
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -2841,6 +2848,9 @@ static poly_exp_t exp_arr2[] = {
 
 #define C PolyFromCoeff
 
+// Liczba elementów tablicy x
+#define SIZE(x) (sizeof (x) / sizeof (x)[0])
+
 static Mono M(Poly p, poly_exp_t n) {
   return MonoFromPoly(&p, n);
 }
@@ -3968,6 +3978,1393 @@ static bool MemoryFreeTest(void) {
   return res;
 }
 
+/** TESTY SZYBKICH ALGORYTMÓW MNOŻENIA **/
+
+/** Stan generatora liczb pseudolosowych używanego w testach. */
+static uint64_t random_state = 88172645463325252ULL;
+
+/**
+ * Losuje 64-bitowe słowo generatorem xorshift, więc wyniki testów nie zależą
+ * od implementacji funkcji rand.
+ */
+static uint64_t RandomWord(void) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 7;
+  random_state ^= random_state << 17;
+  return random_state;
+}
+
+/**
+ * Losuje współczynnik o wartości bezwzględnej mniejszej niż @f$2^{bits}@f$.
+ * Dla @p bits równego 64 losuje dowolny współczynnik, więc iloczyny
+ * przekraczają zakres i są liczone modulo @f$2^{64}@f$.
+ * @param bits liczba bitów wartości bezwzględnej
+ */
+static poly_coeff_t RandomCoeff(int bits) {
+  if (bits >= 64)
+    return (poly_coeff_t)RandomWord();
+  poly_coeff_t abs = (poly_coeff_t)(RandomWord() & ((1ULL << bits) - 1));
+  return RandomWord() % 2 == 0 ? abs : -abs;
+}
+
+/**
+ * Buduje losowy wielomian zmiennych @f$x_0, \ldots, x_{depth-1}@f$, którego
+ * każdy poziom ma co najwyżej @p count jednomianów.
+ * @param depth liczba zmiennych
+ * @param count liczba losowanych jednomianów poziomu
+ * @param max_exp największy wykładnik
+ * @param bits liczba bitów współczynników
+ */
+static Poly RandomPoly(int depth, size_t count, poly_exp_t max_exp, int bits) {
+  if (depth == 0)
+    return C(RandomCoeff(bits));
+  Mono *arr = calloc(count, sizeof (Mono));
+  CHECK_PTR(arr);
+  size_t size = 0;
+  for (size_t i = 0; i < count; i++) {
+    Poly p = RandomPoly(depth - 1, count, max_exp, bits);
+    if (!PolyIsZero(&p))
+      arr[size++] = M(p, (poly_exp_t)(RandomWord() % ((uint64_t)max_exp + 1)));
+  }
+  Poly res = PolyAddMonos(size, arr);
+  free(arr);
+  return res;
+}
+
+/**
+ * Daje tablicę jednomianów pierwszego poziomu wielomianu. Niezerowy
+ * współczynnik @f$c@f$ jest traktowany jak jednomian @f$cx_0^0@f$.
+ * @param p wielomian
+ * @param buffer miejsce na jednomian
+ * @param arr wskaźnik na miejsce na tablicę jednomianów
+ * @return liczba jednomianów
+ */
+static size_t MonosOf(const Poly *p, Mono *buffer, const Mono **arr) {
+  if (PolyIsCoeff(p)) {
+    *buffer = (Mono) {.p = *p, .exp = 0};
+    *arr = buffer;
+    return PolyIsZero(p) ? 0 : 1;
+  }
+  *arr = PolyMonos(p, buffer);
+  return PolySize(p);
+}
+
+/**
+ * Mnoży dwa wielomiany wprost z definicji, dodając iloczyny wszystkich par
+ * jednomianów funkcją PolyAddMonos. Służy jako wzorzec dla szybkich
+ * algorytmów mnożenia.
+ * @param p wielomian
+ * @param q wielomian
+ */
+static Poly NaiveMul(const Poly *p, const Poly *q) {
+  if (PolyIsCoeff(p) && PolyIsCoeff(q))
+    return C((poly_coeff_t)((uint64_t)p->coeff * (uint64_t)q->coeff));
+
+  Mono p_buffer, q_buffer;
+  const Mono *p_arr, *q_arr;
+  size_t p_size = MonosOf(p, &p_buffer, &p_arr);
+  size_t q_size = MonosOf(q, &q_buffer, &q_arr);
+  Mono *arr = calloc(p_size * q_size + 1, sizeof (Mono));
+  CHECK_PTR(arr);
+  size_t count = 0;
+  for (size_t i = 0; i < p_size; i++) {
+    for (size_t j = 0; j < q_size; j++) {
+      Poly prod = NaiveMul(&(p_arr[i].p), &(q_arr[j].p));
+      if (!PolyIsZero(&prod))
+        arr[count++] = M(prod, p_arr[i].exp + q_arr[j].exp);
+    }
+  }
+  Poly res = PolyAddMonos(count, arr);
+  free(arr);
+  return res;
+}
+
+/**
+ * Sprawdza, czy podstawienie Kroneckera daje iloczyn równy iloczynowi
+ * liczonemu z definicji.
+ * @param p wielomian
+ * @param q wielomian
+ * @param is_packed czy iloczyn może być wyliczony przez podstawienie?
+ */
+static bool TestKronecker(Poly p, Poly q, bool is_packed) {
+  Poly expected = NaiveMul(&p, &q);
+  Poly prod = PolyZero();
+  bool res = PolyMulKronecker(&p, &q, &prod) == is_packed;
+  if (is_packed)
+    res &= PolyIsEq(&prod, &expected);
+  PolyDestroy(&prod);
+  prod = PolyMul(&p, &q);
+  res &= PolyIsEq(&prod, &expected);
+  PolyDestroy(&prod);
+  PolyDestroy(&expected);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  return res;
+}
+
+/**
+ * Porównuje mnożenie przez podstawienie Kroneckera z mnożeniem z definicji
+ * dla losowych wielomianów jednej i wielu zmiennych, również z ujemnymi
+ * współczynnikami i iloczynami przekraczającymi zakres.
+ */
+static bool KroneckerMulTest(void) {
+  bool res = true;
+  const int bits[] = {4, 20, 64};
+  for (size_t b = 0; b < SIZE(bits); b++) {
+    // gęste wielomiany jednej zmiennej
+    res &= TestKronecker(RandomPoly(1, 40, 50, bits[b]),
+                         RandomPoly(1, 40, 50, bits[b]), true);
+    // rzadkie wielomiany jednej zmiennej
+    res &= TestKronecker(RandomPoly(1, 30, 100000, bits[b]),
+                         RandomPoly(1, 30, 100000, bits[b]), true);
+    // wielomiany wielu zmiennych
+    res &= TestKronecker(RandomPoly(3, 5, 20, bits[b]),
+                         RandomPoly(2, 6, 30, bits[b]), true);
+    res &= TestKronecker(RandomPoly(4, 3, 7, bits[b]),
+                         RandomPoly(4, 3, 5, bits[b]), true);
+  }
+  // Iloczyny wszystkich par współczynników są podzielne przez 2^64.
+  Poly shift = C((poly_coeff_t)1 << 32);
+  Poly p = RandomPoly(2, 10, 10, 20), q = RandomPoly(2, 10, 10, 20);
+  Poly p_shifted = NaiveMul(&p, &shift), q_shifted = NaiveMul(&q, &shift);
+  res &= TestKronecker(p_shifted, q_shifted, true);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  // Upakowany wykładnik nie mieści się w 64 bitach.
+  res &= TestKronecker(RandomPoly(3, 4, INT_MAX / 2, 10),
+                       RandomPoly(3, 4, INT_MAX / 2, 10), false);
+  // Iloczyn jest zbyt mały, żeby podstawienie się opłacało.
+  res &= TestKronecker(RandomPoly(1, 3, 10, 10), RandomPoly(1, 3, 10, 10),
+                       false);
+  return res;
+}
+
+/**
+ * Losuje tablicę współczynników gęstego wielomianu jednej zmiennej.
+ * @param n liczba współczynników
+ * @param bits liczba bitów współczynników
+ */
+static poly_coeff_t *RandomDense(size_t n, int bits) {
+  poly_coeff_t *arr = malloc(n * sizeof (poly_coeff_t));
+  CHECK_PTR(arr);
+  for (size_t i = 0; i < n; i++)
+    arr[i] = RandomCoeff(bits);
+  return arr;
+}
+
+/**
+ * Sprawdza, czy funkcja mnożąca gęste wielomiany daje dla losowych czynników
+ * taki sam wynik jak mnożenie szkolne. Funkcja może odmówić wyliczenia
+ * iloczynu, zwracając false.
+ * @param n liczba współczynników pierwszego czynnika
+ * @param m liczba współczynników drugiego czynnika
+ * @param bits liczba bitów współczynników
+ * @param mul funkcja mnożąca
+ */
+static bool TestDenseMul(size_t n, size_t m, int bits,
+                         bool (*mul)(const poly_coeff_t [], size_t,
+                                     const poly_coeff_t [], size_t,
+                                     poly_coeff_t [])) {
+  poly_coeff_t *a = RandomDense(n, bits), *b = RandomDense(m, bits);
+  poly_coeff_t *expected = malloc((n + m - 1) * sizeof (poly_coeff_t));
+  poly_coeff_t *prod = malloc((n + m - 1) * sizeof (poly_coeff_t));
+  CHECK_PTR(expected);
+  CHECK_PTR(prod);
+  DenseMulSchoolbook(a, n, b, m, expected);
+  bool res = !mul(a, n, b, m, prod) ||
+             memcmp(prod, expected, (n + m - 1) * sizeof (poly_coeff_t)) == 0;
+  free(a);
+  free(b);
+  free(expected);
+  free(prod);
+  return res;
+}
+
+/**
+ * Tworzy wielomian jednej zmiennej z tablicy współczynników przy kolejnych
+ * potęgach zmiennej.
+ * @param arr tablica współczynników
+ * @param n liczba współczynników
+ */
+static Poly DenseToPoly(const poly_coeff_t arr[], size_t n) {
+  Mono *monos = calloc(n, sizeof (Mono));
+  CHECK_PTR(monos);
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+    if (arr[i] != 0)
+      monos[count++] = M(C(arr[i]), (poly_exp_t)i);
+  Poly res = PolyAddMonos(count, monos);
+  free(monos);
+  return res;
+}
+
+/**
+ * Sprawdza, czy PolyMul daje dla gęstych wielomianów jednej zmiennej taki sam
+ * wynik jak mnożenie szkolne. Mnożenie jest jednowątkowe, żeby czynniki
+ * trafiały w całości do algorytmów mnożenia gęstych wielomianów.
+ * @param n liczba współczynników pierwszego czynnika
+ * @param m liczba współczynników drugiego czynnika
+ * @param bits liczba bitów współczynników
+ */
+static bool TestDensePolyMul(size_t n, size_t m, int bits) {
+  poly_coeff_t *a = RandomDense(n, bits), *b = RandomDense(m, bits);
+  poly_coeff_t *expected = malloc((n + m - 1) * sizeof (poly_coeff_t));
+  CHECK_PTR(expected);
+  DenseMulSchoolbook(a, n, b, m, expected);
+  Poly p = DenseToPoly(a, n), q = DenseToPoly(b, m);
+  Poly res = DenseToPoly(expected, n + m - 1);
+
+  size_t num_of_threads = PolyMulGetNumOfThreads();
+  PolyMulSetNumOfThreads(1);
+  bool is_eq = TestMul(p, q, res);
+  PolyMulSetNumOfThreads(num_of_threads);
+  free(a);
+  free(b);
+  free(expected);
+  return is_eq;
+}
+
+/**
+ * Wywołuje DenseMulKaratsuba z sygnaturą funkcji, która może odmówić
+ * wyliczenia iloczynu.
+ */
+static bool KaratsubaMul(const poly_coeff_t a[], size_t n,
+                         const poly_coeff_t b[], size_t m, poly_coeff_t res[]) {
+  DenseMulKaratsuba(a, n, b, m, res);
+  return true;
+}
+
+/**
+ * Porównuje algorytm Karatsuby z mnożeniem szkolnym dla czynników różnych
+ * długości, po obu stronach progu przejścia na mnożenie szkolne.
+ */
+static bool KaratsubaMulTest(void) {
+  bool res = true;
+  const size_t sizes[][2] = {
+    {1, 1}, {1, 50}, {5, 40}, {31, 31}, {32, 32}, {33, 33}, {33, 34},
+    {31, 100}, {64, 64}, {100, 257}, {257, 100}, {500, 1000}, {1000, 1000}
+  };
+  const int bits[] = {4, 20, 64};
+  for (size_t s = 0; s < SIZE(sizes); s++)
+    for (size_t b = 0; b < SIZE(bits); b++)
+      res &= TestDenseMul(sizes[s][0], sizes[s][1], bits[b], KaratsubaMul);
+
+  // PolyMul przechodzi na algorytm Karatsuby dla gęstych czynników.
+  res &= TestDensePolyMul(40, 40, 64);
+  res &= TestDensePolyMul(300, 200, 20);
+  return res;
+}
+
+/**
+ * Porównuje mnożenie szybką transformatą z mnożeniem szkolnym. Małe
+ * współczynniki wymagają jednej liczby pierwszej, średnie dwóch, a dowolne
+ * 64-bitowe trzech i odtworzenia wyniku algorytmem Garnera.
+ */
+static bool NttMulTest(void) {
+  bool res = true;
+  const size_t sizes[][2] = {
+    {1, 1}, {1, 7}, {3, 5}, {64, 64}, {100, 37}, {513, 1000}, {1024, 1025}
+  };
+  const int bits[] = {8, 28, 40, 64};
+  for (size_t s = 0; s < SIZE(sizes); s++)
+    for (size_t b = 0; b < SIZE(bits); b++)
+      res &= TestDenseMul(sizes[s][0], sizes[s][1], bits[b], DenseMulNtt);
+
+  // PolyMul przechodzi na szybką transformatę z jedną i z dwiema liczbami
+  // pierwszymi.
+  res &= TestDensePolyMul(4096, 4100, 8);
+  res &= TestDensePolyMul(16384, 16384, 24);
+  return res;
+}
+
+/** TESTY OPERACJI PRZEJMUJĄCYCH WIELOMIANY NA WŁASNOŚĆ **/
+
+/**
+ * Robi kopię wielomianu, która nie współdzieli z nim żadnej tablicy
+ * jednomianów. Pozwala sprawdzić, czy operacja nie zmieniła wielomianu
+ * współdzielącego pamięć z jej argumentem.
+ * @param p wielomian
+ */
+static Poly DeepCopy(const Poly *p) {
+  if (PolyIsCoeff(p))
+    return *p;
+  Mono buffer;
+  const Mono *arr;
+  size_t size = MonosOf(p, &buffer, &arr);
+  Mono *monos = calloc(size, sizeof (Mono));
+  CHECK_PTR(monos);
+  for (size_t i = 0; i < size; i++)
+    monos[i] = M(DeepCopy(&(arr[i].p)), arr[i].exp);
+  Poly res = PolyAddMonos(size, monos);
+  free(monos);
+  return res;
+}
+
+/**
+ * Sprawdza, czy operacja przejmująca wielomiany na własność daje taki sam
+ * wynik jak operacja je kopiująca. Wynik operacji kopiującej jest liczony
+ * przed wywołaniem operacji przejmującej, która może modyfikować argumenty.
+ * @param a wielomian przejmowany na własność
+ * @param b wielomian przejmowany na własność
+ * @param op operacja kopiująca
+ * @param op_own operacja przejmująca wielomiany na własność
+ */
+static bool TestOpOwn(Poly a, Poly b, Poly (*op)(const Poly *, const Poly *),
+                      Poly (*op_own)(Poly *, Poly *)) {
+  Poly expected = op(&a, &b);
+  Poly c = op_own(&a, &b);
+  bool is_eq = PolyIsEq(&c, &expected);
+  PolyDestroy(&c);
+  PolyDestroy(&expected);
+  return is_eq;
+}
+
+/**
+ * Sprawdza PolyAddOwn, PolySubOwn i PolyMulOwn dla argumentów
+ * niewspółdzielących pamięci, będących kopiami tego samego wielomianu
+ * i współdzielących poziomy z innymi wielomianami, które nie mogą się zmienić.
+ */
+static bool OwnOpsTest(void) {
+  bool res = true;
+  Poly (*const ops[])(const Poly *, const Poly *) = {PolyAdd, PolySub, PolyMul};
+  Poly (*const ops_own[])(Poly *, Poly *) = {PolyAddOwn, PolySubOwn,
+                                              PolyMulOwn};
+  for (size_t k = 0; k < SIZE(ops); k++) {
+    res &= TestOpOwn(C(3), C(-5), ops[k], ops_own[k]);
+    res &= TestOpOwn(C(0), P(C(1), 2), ops[k], ops_own[k]);
+    res &= TestOpOwn(P(C(1), 2), C(0), ops[k], ops_own[k]);
+    res &= TestOpOwn(C(7), P(P(C(1), 1), 0, C(2), 3), ops[k], ops_own[k]);
+    res &= TestOpOwn(P(C(1), 1, C(2), 3), C(-1), ops[k], ops_own[k]);
+    res &= TestOpOwn(P(C(1), 1), P(C(-1), 1), ops[k], ops_own[k]);
+    res &= TestOpOwn(P(C(1), 1, P(C(2), 2), 5), P(C(-1), 1, P(C(-2), 2), 5),
+                     ops[k], ops_own[k]);
+    res &= TestOpOwn(RandomPoly(3, 4, 6, 10), RandomPoly(3, 4, 6, 10),
+                     ops[k], ops_own[k]);
+
+    // Argumenty są kopiami tego samego wielomianu.
+    Poly p = RandomPoly(3, 4, 6, 10);
+    Poly p_deep = DeepCopy(&p);
+    res &= TestOpOwn(PolyClone(&p), PolyClone(&p), ops[k], ops_own[k]);
+    res &= TestOpOwn(PolyClone(&p), DeepCopy(&p), ops[k], ops_own[k]);
+    res &= PolyIsEq(&p, &p_deep);
+
+    // Argumenty współdzielą poziomy z innymi wielomianami.
+    Poly q = RandomPoly(2, 5, 8, 10), r = RandomPoly(2, 5, 8, 10);
+    Poly q_deep = DeepCopy(&q), r_deep = DeepCopy(&r);
+    res &= TestOpOwn(P(PolyClone(&q), 1, C(4), 2),
+                     P(PolyClone(&r), 1, PolyClone(&q), 2), ops[k], ops_own[k]);
+    res &= TestOpOwn(P(PolyClone(&p), 0, PolyClone(&q), 1),
+                     P(PolyClone(&p), 0, PolyClone(&r), 3), ops[k], ops_own[k]);
+    res &= PolyIsEq(&p, &p_deep) && PolyIsEq(&q, &q_deep) &&
+           PolyIsEq(&r, &r_deep);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    PolyDestroy(&p_deep);
+    PolyDestroy(&q_deep);
+    PolyDestroy(&r_deep);
+  }
+  return res;
+}
+
+/**
+ * Sprawdza PolyNegOwn dla współczynnika, jednomianu ze stałym
+ * współczynnikiem oraz dla wielomianu współdzielonego i niewspółdzielonego.
+ */
+static bool NegOwnTest(void) {
+  bool res = true;
+  Poly p = RandomPoly(3, 5, 10, 20);
+  Poly polys[] = {C(0), C(-9), P(C(3), 4), P(P(C(3), 4), 2), p};
+  for (size_t i = 0; i < SIZE(polys); i++) {
+    Poly deep = DeepCopy(&(polys[i]));
+    Poly expected = PolyNeg(&(polys[i]));
+    Poly copy = PolyClone(&(polys[i]));
+    Poly neg = PolyNegOwn(&copy);
+    res &= PolyIsEq(&neg, &expected) && PolyIsEq(&(polys[i]), &deep);
+    PolyDestroy(&neg);
+    neg = PolyNegOwn(&deep);
+    res &= PolyIsEq(&neg, &expected);
+    PolyDestroy(&neg);
+    PolyDestroy(&expected);
+    PolyDestroy(&(polys[i]));
+  }
+  return res;
+}
+
+/**
+ * Sprawdza, czy PolySub daje taki sam wynik jak dodanie wielomianu
+ * przeciwnego, a PolyNeg jest inwolucją.
+ * @param p wielomian
+ * @param q wielomian
+ */
+static bool TestSubNeg(Poly p, Poly q) {
+  Poly neg_q = PolyNeg(&q);
+  Poly expected = PolyAdd(&p, &neg_q);
+  Poly neg_neg_q = PolyNeg(&neg_q);
+  bool res = PolyIsEq(&neg_neg_q, &q);
+  PolyDestroy(&neg_q);
+  PolyDestroy(&neg_neg_q);
+  return res && TestSub(p, q, expected);
+}
+
+/**
+ * Porównuje odejmowanie z dodawaniem wielomianu przeciwnego, również dla
+ * argumentów będących tym samym wielomianem albo współdzielących poziomy.
+ */
+static bool SubNegTest(void) {
+  bool res = true;
+  res &= TestSubNeg(C(1), P(C(1), 1));
+  res &= TestSubNeg(P(C(1), 1), C(1));
+  res &= TestSubNeg(P(C(1), 1, C(2), 2), P(C(1), 1, C(3), 2));
+  res &= TestSubNeg(P(P(C(1), 2), 1), P(P(C(1), 2, C(1), 3), 1));
+  for (int i = 0; i < 10; i++)
+    res &= TestSubNeg(RandomPoly(3, 4, 5, 64), RandomPoly(3, 4, 5, 64));
+
+  Poly p = RandomPoly(3, 4, 5, 20);
+  Poly q = P(PolyClone(&p), 0, PolyClone(&p), 2);
+  res &= TestSubNeg(PolyClone(&p), PolyClone(&p));
+  res &= TestSubNeg(PolyClone(&q), P(PolyClone(&p), 2));
+
+  // Argumenty wskazują na ten sam wielomian.
+  Poly two = C(2);
+  Poly twice = NaiveMul(&p, &two);
+  Poly square = NaiveMul(&p, &p);
+  res &= TestOpPtr(&p, &p, PolyZero(), PolySub);
+  res &= TestOpPtr(&p, &p, twice, PolyAdd);
+  res &= TestOpPtr(&p, &p, square, PolyMul);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  return res;
+}
+
+/**
+ * Wylicza wartość wielomianu w punkcie wprost z definicji, mnożąc każdy
+ * współczynnik przez osobno wyliczoną potęgę @p x.
+ * @param p wielomian
+ * @param x wartość argumentu
+ */
+static Poly NaiveAt(const Poly *p, poly_coeff_t x) {
+  if (PolyIsCoeff(p))
+    return *p;
+  Mono buffer;
+  const Mono *arr;
+  size_t size = MonosOf(p, &buffer, &arr);
+  Poly res = PolyZero();
+  for (size_t i = 0; i < size; i++) {
+    uint64_t x_pow = 1;
+    for (poly_exp_t e = 0; e < arr[i].exp; e++)
+      x_pow *= (uint64_t)x;
+    Poly multiplier = C((poly_coeff_t)x_pow);
+    Poly term = NaiveMul(&(arr[i].p), &multiplier);
+    Poly sum = PolyAdd(&res, &term);
+    PolyDestroy(&res);
+    PolyDestroy(&term);
+    res = sum;
+  }
+  return res;
+}
+
+/**
+ * Porównuje PolyAt z wartością liczoną z definicji. Punkty obejmują zero,
+ * jedynkę, liczby ujemne i liczby, których potęgi przekraczają zakres albo
+ * stają się zerowe modulo @f$2^{64}@f$, a wielomiany również takie, których
+ * współczynniki się znoszą lub współdzielą poziomy.
+ */
+static bool PolyAtNaiveTest(void) {
+  bool res = true;
+  const poly_coeff_t points[] = {
+    0, 1, -1, 2, -3, 1000003, (poly_coeff_t)1 << 32, (poly_coeff_t)1 << 21,
+    LONG_MAX, LONG_MIN
+  };
+  Poly q = RandomPoly(2, 4, 6, 30);
+  Poly polys[] = {
+    C(5),
+    P(C(3), 7),
+    P(P(C(-1), 1), 0, P(C(1), 1), 1),
+    P(C(1), 0, P(C(1), 1), 1, C(-1), 2),
+    P(PolyClone(&q), 1, PolyClone(&q), 3, P(PolyClone(&q), 2), 4),
+    RandomPoly(1, 20, 100, 64),
+    RandomPoly(2, 6, 40, 64),
+    RandomPoly(3, 4, 10, 20)
+  };
+  for (size_t i = 0; i < SIZE(polys); i++) {
+    for (size_t j = 0; j < SIZE(points); j++)
+      res &= TestAt(PolyClone(&(polys[i])), points[j],
+                    NaiveAt(&(polys[i]), points[j]));
+    PolyDestroy(&(polys[i]));
+  }
+  PolyDestroy(&q);
+  return res;
+}
+
+/**
+ * Wylicza złożenie wielomianu wprost z definicji, wyliczając każdą potęgę
+ * podstawianego wielomianu osobno przez kolejne mnożenia.
+ * @param p wielomian
+ * @param k rozmiar tablicy @p q
+ * @param q wielomiany podstawiane w miejsce zmiennych
+ * @param index indeks wielomianu w @p q podstawianego za @f$x_0@f$
+ */
+static Poly NaiveCompose(const Poly *p, size_t k, const Poly q[],
+                         size_t index) {
+  if (PolyIsCoeff(p))
+    return *p;
+  Mono buffer;
+  const Mono *arr;
+  size_t size = MonosOf(p, &buffer, &arr);
+  Poly res = PolyZero();
+  for (size_t i = 0; i < size; i++) {
+    Poly factor = C(index < k || arr[i].exp == 0 ? 1 : 0);
+    for (poly_exp_t e = 0; index < k && e < arr[i].exp; e++) {
+      Poly next = NaiveMul(&factor, &(q[index]));
+      PolyDestroy(&factor);
+      factor = next;
+    }
+    Poly child = NaiveCompose(&(arr[i].p), k, q, index + 1);
+    Poly term = NaiveMul(&child, &factor);
+    Poly sum = PolyAdd(&res, &term);
+    PolyDestroy(&res);
+    PolyDestroy(&term);
+    PolyDestroy(&child);
+    PolyDestroy(&factor);
+    res = sum;
+  }
+  return res;
+}
+
+/**
+ * Sprawdza, czy PolyCompose i obiekt składający dają taki sam wynik jak
+ * złożenie liczone z definicji.
+ * @param composer obiekt składający z tablicą @p q
+ * @param p wielomian
+ * @param k rozmiar tablicy @p q
+ * @param q wielomiany podstawiane w miejsce zmiennych
+ */
+static bool TestCompose(PolyComposer *composer, Poly p, size_t k,
+                        const Poly q[]) {
+  Poly expected = NaiveCompose(&p, k, q, 0);
+  Poly composed = PolyCompose(&p, k, q);
+  Poly applied = PolyComposerApply(composer, &p);
+  bool res = PolyIsEq(&composed, &expected) && PolyIsEq(&applied, &expected);
+  PolyDestroy(&p);
+  PolyDestroy(&expected);
+  PolyDestroy(&composed);
+  PolyDestroy(&applied);
+  return res;
+}
+
+/**
+ * Porównuje złożenia z definicją. Kolejne złożenia korzystają z jednego
+ * obiektu składającego, więc zapamiętane potęgi mają luki wypełniane
+ * w dowolnej kolejności. Podstawiane wielomiany są też kopiami jednego
+ * wielomianu, wielomianem składanym, zerem albo współczynnikiem.
+ */
+static bool ComposeNaiveTest(void) {
+  bool res = true;
+  Poly p = RandomPoly(2, 3, 4, 10);
+  Poly q[] = {RandomPoly(2, 3, 3, 10), PolyClone(&p), PolyClone(&p), C(0),
+              C(-3)};
+  const size_t k = SIZE(q);
+  // Wykładniki x_0 w kolejności, w której trafiają do obiektu składającego.
+  const poly_exp_t exps[] = {9, 3, 5, 12, 1, 10, 2, 11, 4};
+  for (size_t n = 1; n <= k; n++) {
+    PolyComposer composer = PolyComposerNew(n, q);
+    for (size_t i = 0; i < SIZE(exps); i++) {
+      res &= TestCompose(&composer, P(C(1), exps[i]), n, q);
+      res &= TestCompose(&composer, P(C(2), 0, PolyClone(&p), exps[i]), n, q);
+    }
+    res &= TestCompose(&composer, PolyClone(&p), n, q);
+    res &= TestCompose(&composer, RandomPoly(k + 1, 2, 4, 10), n, q);
+    res &= TestCompose(&composer, P(P(P(P(C(1), 2), 3), 1), 2), n, q);
+    PolyComposerDestroy(&composer);
+  }
+  PolyComposer empty = PolyComposerNew(0, NULL);
+  res &= TestCompose(&empty, RandomPoly(3, 3, 4, 10), 0, NULL);
+  PolyComposerDestroy(&empty);
+  for (size_t i = 0; i < k; i++)
+    PolyDestroy(&(q[i]));
+  PolyDestroy(&p);
+  return res;
+}
+
+/**
+ * Porównuje złożenia PolyComposerApplyBatch z kolejnymi wywołaniami
+ * PolyCompose dla tablic różnych rozmiarów, również z powtarzającymi się
+ * wielomianami.
+ */
+static bool ComposeBatchTest(void) {
+  bool res = true;
+  Poly q[] = {RandomPoly(2, 3, 3, 10), C(2), RandomPoly(1, 2, 4, 64)};
+  const size_t k = SIZE(q);
+  const size_t n = 6;
+  Poly p[n];
+  for (size_t i = 0; i + 1 < n; i++)
+    p[i] = RandomPoly(3, 3, 5, 20);
+  p[n - 1] = PolyClone(&(p[0]));
+
+  for (size_t count = 1; count <= n; count++) {
+    Poly results[n];
+    PolyComposer composer = PolyComposerNew(k, q);
+    PolyComposerApplyBatch(&composer, count, p, results);
+    PolyComposerDestroy(&composer);
+    for (size_t i = 0; i < count; i++) {
+      Poly expected = PolyCompose(&(p[i]), k, q);
+      res &= PolyIsEq(&(results[i]), &expected);
+      PolyDestroy(&expected);
+      PolyDestroy(&(results[i]));
+    }
+  }
+
+  for (size_t i = 0; i < n; i++)
+    PolyDestroy(&(p[i]));
+  for (size_t i = 0; i < k; i++)
+    PolyDestroy(&(q[i]));
+  return res;
+}
+
+/** TESTY WYLICZANIA WARTOŚCI **/
+
+/**
+ * Buduje wielomian @f$x_0 x_1 \cdots x_{depth-1} + \ldots@f$ o zadanej
+ * głębokości, w którym każdy poziom ma jednomian z wyrazem wolnym
+ * i jednomian zawierający kolejny poziom.
+ * @param depth liczba poziomów
+ */
+static Poly DeepPoly(size_t depth) {
+  Poly p = C(3);
+  for (size_t i = 0; i < depth; i++)
+    p = P(C((poly_coeff_t)i - 5), 0, p, (poly_exp_t)(i % 3 + 1));
+  return p;
+}
+
+/**
+ * Tworzy tablicę wielomianów, na których są porównywane sposoby wyliczania
+ * wartości: zero, stałe, jednomiany, głęboko zagnieżdżone i losowe
+ * wielomiany o współczynnikach przekraczających zakres przy mnożeniu.
+ * @param count wskaźnik na miejsce na rozmiar tablicy
+ */
+static Poly *EvalTestPolys(size_t *count) {
+  Poly polys[] = {
+    C(0), C(7), C(LONG_MIN), P(C(-2), 5), P(P(C(4), 3), 0, C(1), 2),
+    DeepPoly(8), DeepPoly(60), RandomPoly(1, 30, 200, 64),
+    RandomPoly(3, 5, 10, 64), RandomPoly(5, 3, 40, 20)
+  };
+  *count = SIZE(polys);
+  Poly *arr = malloc(sizeof (polys));
+  CHECK_PTR(arr);
+  memcpy(arr, polys, sizeof (polys));
+  return arr;
+}
+
+/**
+ * Losuje współrzędne @p n punktów o @p k współrzędnych. Obok dowolnych
+ * liczb pojawiają się 0, 1 i -1.
+ * @param k liczba współrzędnych
+ * @param n liczba punktów
+ */
+static poly_coeff_t *RandomPoints(size_t k, size_t n) {
+  poly_coeff_t *points = malloc((k * n + 1) * sizeof (poly_coeff_t));
+  CHECK_PTR(points);
+  for (size_t i = 0; i < k * n; i++) {
+    uint64_t kind = RandomWord() % 8;
+    points[i] = kind < 3 ? (poly_coeff_t)kind - 1 : RandomCoeff(64);
+  }
+  return points;
+}
+
+/** Liczby punktów, dla których są porównywane sposoby wyliczania wartości. */
+static const size_t eval_test_sizes[] = {0, 1, 3, 63, 64, 65, 127, 200};
+
+/** Liczby współrzędnych punktów, również mniejsze od liczby zmiennych. */
+static const size_t eval_test_vars[] = {0, 1, 3, 7, 70};
+
+/**
+ * Porównuje PolyEvalBatch z PolyEval wywoływaną dla każdego punktu osobno.
+ * Liczby punktów nie muszą być wielokrotnościami rozmiaru bloku.
+ */
+static bool EvalBatchTest(void) {
+  bool res = true;
+  size_t count;
+  Poly *polys = EvalTestPolys(&count);
+  for (size_t i = 0; i < count; i++) {
+    for (size_t v = 0; v < SIZE(eval_test_vars); v++) {
+      for (size_t s = 0; s < SIZE(eval_test_sizes); s++) {
+        size_t k = eval_test_vars[v], n = eval_test_sizes[s];
+        poly_coeff_t *points = RandomPoints(k, n);
+        poly_coeff_t *out = malloc((n + 1) * sizeof (poly_coeff_t));
+        CHECK_PTR(out);
+        PolyEvalBatch(&(polys[i]), k, n, points, out);
+        for (size_t j = 0; j < n; j++)
+          res &= out[j] == PolyEval(&(polys[i]), k, points + j * k);
+        free(points);
+        free(out);
+      }
+    }
+    PolyDestroy(&(polys[i]));
+  }
+  free(polys);
+  return res;
+}
+
+/**
+ * Porównuje wartości wielomianów skompilowanych do programu z PolyEval.
+ * Jeden program jest wykonywany wielokrotnie dla różnych punktów.
+ */
+static bool ProgramEvalTest(void) {
+  bool res = true;
+  size_t count;
+  Poly *polys = EvalTestPolys(&count);
+  for (size_t i = 0; i < count; i++) {
+    PolyProgram program = PolyProgramNew(&(polys[i]));
+    for (size_t v = 0; v < SIZE(eval_test_vars); v++) {
+      size_t k = eval_test_vars[v], n = 20;
+      poly_coeff_t *points = RandomPoints(k, n);
+      for (size_t j = 0; j < n; j++)
+        res &= PolyProgramEval(&program, k, points + j * k) ==
+               PolyEval(&(polys[i]), k, points + j * k);
+      free(points);
+    }
+    PolyProgramDestroy(&program);
+    PolyDestroy(&(polys[i]));
+  }
+  free(polys);
+  return res;
+}
+
+/**
+ * Porównuje wartości wielomianów przetłumaczonych na kod maszynowy
+ * z PolyEval. Na platformach bez kodu maszynowego sprawdza interpreter,
+ * z którego wtedy korzysta PolyJitEval.
+ */
+static bool JitEvalTest(void) {
+  bool res = true;
+  size_t count;
+  Poly *polys = EvalTestPolys(&count);
+  for (size_t i = 0; i < count; i++) {
+    PolyJit jit = PolyJitNew(&(polys[i]));
+    for (size_t v = 0; v < SIZE(eval_test_vars); v++) {
+      size_t k = eval_test_vars[v], n = 20;
+      poly_coeff_t *points = RandomPoints(k, n);
+      for (size_t j = 0; j < n; j++)
+        res &= PolyJitEval(&jit, k, points + j * k) ==
+               PolyEval(&(polys[i]), k, points + j * k);
+      free(points);
+    }
+    PolyJitDestroy(&jit);
+    PolyDestroy(&(polys[i]));
+  }
+  free(polys);
+  return res;
+}
+
+/**
+ * Sprawdza, czy przekształcenie wielomianu do postaci rozwiniętej, przy
+ * najmniejszej i największej liczbie bitów wykładnika, i z powrotem daje
+ * ten sam wielomian.
+ * @param p wielomian
+ */
+static bool TestDistRoundTrip(const Poly *p) {
+  bool res = true;
+  unsigned int bits[] = {PolyDistBits(p), DIST_MAX_BITS};
+  for (size_t i = 0; i < SIZE(bits); i++) {
+    PolyDist dist;
+    if (!PolyDistFromPoly(p, bits[i], &dist))
+      return false;
+    Poly q = PolyDistToPoly(&dist);
+    res &= PolyIsEq(p, &q);
+    PolyDestroy(&q);
+    PolyDistDestroy(&dist);
+  }
+  return res;
+}
+
+/**
+ * Sprawdza, czy przekształcenie do postaci rozwiniętej z @p bits bitami
+ * wykładnika się nie udaje i nie modyfikuje wyniku.
+ * @param p wielomian
+ * @param bits liczba bitów wykładnika
+ */
+static bool TestDistFails(Poly p, unsigned int bits) {
+  PolyDist dist = {.bits = 77, .size = 123, .terms = NULL};
+  bool res = !PolyDistFromPoly(&p, bits, &dist) && dist.bits == 77 &&
+             dist.size == 123 && dist.terms == NULL;
+  PolyDestroy(&p);
+  return res;
+}
+
+/**
+ * Porównuje dodawanie i porównywanie wielomianów w postaci rozwiniętej
+ * z PolyAdd i PolyIsEq.
+ * @param p wielomian
+ * @param q wielomian
+ */
+static bool TestDistAddIsEq(const Poly *p, const Poly *q) {
+  unsigned int bits = PolyDistBits(p);
+  if (PolyDistBits(q) > bits)
+    bits = PolyDistBits(q);
+  PolyDist p_dist, q_dist;
+  if (!PolyDistFromPoly(p, bits, &p_dist))
+    return false;
+  if (!PolyDistFromPoly(q, bits, &q_dist)) {
+    PolyDistDestroy(&p_dist);
+    return false;
+  }
+  bool res = PolyDistIsEq(&p_dist, &q_dist) == PolyIsEq(p, q);
+  res &= PolyDistIsEq(&p_dist, &p_dist);
+  PolyDist sum_dist = PolyDistAdd(&p_dist, &q_dist);
+  Poly sum = PolyDistToPoly(&sum_dist);
+  Poly expected = PolyAdd(p, q);
+  res &= PolyIsEq(&sum, &expected);
+  PolyDestroy(&sum);
+  PolyDestroy(&expected);
+  PolyDistDestroy(&sum_dist);
+  PolyDistDestroy(&q_dist);
+  PolyDistDestroy(&p_dist);
+  return res;
+}
+
+/**
+ * Porównuje mnożenie rozdzielone między wątki z mnożeniem jednowątkowym.
+ * Czynniki dają ponad @f$2^{20}@f$ iloczynów jednomianów, więc przekraczają
+ * próg mnożenia współbieżnego. Przy większej liczbie wątków niż jednomianów
+ * pierwszego poziomu każdy blok ma jeden jednomian, również taki, którego
+ * współczynnik jest liczbą.
+ */
+static bool ParallelMulTest(void) {
+  bool res = true;
+  size_t num_of_threads = PolyMulGetNumOfThreads();
+  Poly p = RandomPoly(2, 32, 1000, 20), q = RandomPoly(2, 40, 1000, 20);
+  Poly terms = P(C(5), 0, C(-3), 1001);
+  Poly tmp = PolyAdd(&p, &terms);
+  PolyDestroy(&p);
+  PolyDestroy(&terms);
+  p = tmp;
+
+  PolyMulSetNumOfThreads(1);
+  Poly expected = PolyMul(&p, &q);
+  size_t threads[] = {2, 3, 4, 1000};
+  for (size_t i = 0; i < SIZE(threads); i++) {
+    PolyMulSetNumOfThreads(threads[i]);
+    Poly prod = PolyMul(&p, &q);
+    res &= PolyIsEq(&prod, &expected);
+    PolyDestroy(&prod);
+    prod = PolyMul(&q, &p);
+    res &= PolyIsEq(&prod, &expected);
+    PolyDestroy(&prod);
+  }
+  PolyMulSetNumOfThreads(num_of_threads);
+  PolyDestroy(&expected);
+  PolyDestroy(&q);
+  PolyDestroy(&p);
+  return res;
+}
+
+/**
+ * Sprawdza wielomiany w postaci rozwiniętej: przekształcanie w obie strony,
+ * odmowę przekształcenia przy zbyt wielu zmiennych lub zbyt dużych
+ * wykładnikach oraz dodawanie i porównywanie z PolyAdd i PolyIsEq.
+ */
+static bool DistTest(void) {
+  bool res = true;
+
+  Poly fixed[] = {
+    C(0),
+    C(-7),
+    P(C(1), 1),
+    P(C(2), 0, P(C(1), 1), 3),
+    P(P(C(1), 2), 0, C(4), 1),
+    P(C(LONG_MAX), INT_MAX),
+    DeepPoly(2 * DIST_WORDS)
+  };
+  for (size_t i = 0; i < SIZE(fixed); i++) {
+    res &= TestDistRoundTrip(&(fixed[i]));
+    for (size_t j = 0; j < SIZE(fixed); j++)
+      res &= TestDistAddIsEq(&(fixed[i]), &(fixed[j]));
+  }
+  for (size_t i = 0; i < SIZE(fixed); i++)
+    PolyDestroy(&(fixed[i]));
+
+  for (int t = 0; t < 200; t++) {
+    // Przy 32 bitach wykładnika w słowie mieszczą się dwie zmienne.
+    int depth = (int)(RandomWord() % (2 * DIST_WORDS + 1));
+    poly_exp_t max_exp = t % 2 == 0 ? 5 : INT_MAX;
+    Poly p = RandomPoly(depth, 4, max_exp, 64);
+    Poly q = RandomPoly(depth, 4, max_exp, 64);
+    Poly neg = PolyNeg(&p);
+    res &= TestDistRoundTrip(&p);
+    res &= TestDistAddIsEq(&p, &q);
+    res &= TestDistAddIsEq(&p, &neg);
+    res &= TestDistAddIsEq(&p, &p);
+    PolyDestroy(&neg);
+    PolyDestroy(&q);
+    PolyDestroy(&p);
+  }
+
+  // Wykładniki nie mieszczą się w liczbie bitów.
+  res &= TestDistFails(P(C(1), 4), 2);
+  res &= TestDistFails(P(C(1), 0, P(C(1), 1), 1 << 20), 20);
+  res &= TestDistFails(P(C(1), INT_MAX), 30);
+  // Wielomian zależy od zbyt wielu zmiennych.
+  res &= TestDistFails(DeepPoly(DIST_WORDS * (64 / 32) + 1), 32);
+  res &= TestDistFails(DeepPoly(DIST_WORDS * (64 / 2) + 1), 2);
+  res &= TestDistFails(DeepPoly(DIST_WORDS * (64 / 3) + 1), 3);
+
+  // Największa dopuszczalna liczba zmiennych.
+  Poly deep = DeepPoly(DIST_WORDS * (64 / 2));
+  PolyDist dist;
+  bool packed = PolyDistFromPoly(&deep, 2, &dist);
+  res &= packed;
+  if (packed) {
+    Poly q = PolyDistToPoly(&dist);
+    res &= PolyIsEq(&deep, &q);
+    PolyDestroy(&q);
+    PolyDistDestroy(&dist);
+  }
+  PolyDestroy(&deep);
+  return res;
+}
+
+/**
+ * Sprawdza, czy żaden poziom wielomianu nie pochodzi z obszaru.
+ * @param p wielomian
+ */
+static bool IsOutsideArena(const Poly *p) {
+  if (PolyIsCoeff(p) || PolyIsInline(p))
+    return true;
+  if (PolyMonosIsInArena(p->arr))
+    return false;
+  for (size_t i = 0; i < p->size; i++)
+    if (!IsOutsideArena(&(p->arr[i].p)))
+      return false;
+  return true;
+}
+
+/**
+ * Sprawdza, czy pierwszy poziom wielomianu pochodzi z obszaru.
+ * @param p wielomian mający tablicę jednomianów
+ */
+static bool IsInArena(const Poly *p) {
+  return !PolyIsCoeff(p) && !PolyIsInline(p) && PolyMonosIsInArena(p->arr);
+}
+
+/**
+ * Sprawdza obszary: tablice tworzone w obszarze pochodzą z niego, a wynik
+ * kończonego obszaru jest kopiowany poza niego, również z zagnieżdżonych
+ * obszarów, przy czym poziomy utworzone przed obszarem są współdzielone
+ * z kopią. Tablice przydzielane przy zawieszonym obszarze pochodzą spoza
+ * niego.
+ */
+static bool ArenaTest(void) {
+  bool res = true;
+  Poly outside = P(P(C(1), 1, C(2), 2), 1, P(C(3), 1, C(4), 3), 2);
+  Poly p = P(RandomPoly(2, 6, 10, 20), 0, P(C(1), 0, C(5), 4), 3);
+  Poly q = P(P(C(2), 1, C(-1), 2), 1, RandomPoly(2, 6, 10, 20), 5);
+  Poly sum = PolyAdd(&p, &q);
+  Poly expected = PolyMul(&sum, &outside);
+
+  PolyArena arena;
+  PolyArenaBegin(&arena, false);
+  Poly a = DeepCopy(&p), b = DeepCopy(&q);
+  res &= IsInArena(&a) && IsInArena(&b);
+  Poly a_sum = PolyAdd(&a, &b);
+  Poly prod = PolyMul(&a_sum, &outside);
+  PolyDestroy(&a);
+  PolyDestroy(&b);
+  PolyDestroy(&a_sum);
+  Poly exported = PolyArenaEnd(&arena, &prod);
+  res &= IsOutsideArena(&exported) && PolyIsEq(&exported, &expected);
+  PolyDestroy(&exported);
+
+  PolyArenaBegin(&arena, false);
+  Poly with_outside = P(PolyClone(&outside), 1, C(1), 2);
+  res &= IsInArena(&with_outside);
+  exported = PolyArenaEnd(&arena, &with_outside);
+  res &= IsOutsideArena(&exported) && exported.arr[0].p.arr == outside.arr;
+  PolyDestroy(&exported);
+
+  // Wynik wewnętrznego obszaru trafia do zewnętrznego i może współdzielić
+  // z nim poziomy.
+  PolyArena outer, inner;
+  PolyArenaBegin(&outer, false);
+  Poly c = DeepCopy(&p);
+  PolyArenaBegin(&inner, false);
+  Poly d = DeepCopy(&q);
+  Poly inner_sum = PolyAdd(&c, &d);
+  PolyDestroy(&d);
+  Poly inner_res = PolyArenaEnd(&inner, &inner_sum);
+  res &= IsInArena(&inner_res) && PolyIsEq(&inner_res, &sum);
+  PolyDestroy(&c);
+  exported = PolyArenaEnd(&outer, &inner_res);
+  res &= IsOutsideArena(&exported) && PolyIsEq(&exported, &sum);
+  PolyDestroy(&exported);
+
+  PolyArenaBegin(&arena, false);
+  PolyArena *suspended = PolyArenaSuspend();
+  res &= suspended == &arena;
+  Poly heap = DeepCopy(&p);
+  PolyArenaResume(suspended);
+  Poly in_arena = DeepCopy(&q);
+  res &= IsOutsideArena(&heap) && IsInArena(&in_arena);
+  PolyDestroy(&in_arena);
+  Poly zero = C(0);
+  exported = PolyArenaEnd(&arena, &zero);
+  res &= PolyIsZero(&exported) && PolyIsEq(&heap, &p);
+  PolyDestroy(&heap);
+
+  PolyDestroy(&expected);
+  PolyDestroy(&sum);
+  PolyDestroy(&q);
+  PolyDestroy(&p);
+  PolyDestroy(&outside);
+  return res;
+}
+
+/**
+ * Sprawdza statystyki puli i ponowne użycie zwolnionych bloków. Bez puli
+ * wszystkie statystyki są zerowe.
+ */
+static bool PoolTest(void) {
+  bool res = true;
+  PolyAllocStats before = PolyAllocGetStats();
+  Mono *arr = PolyMonosAlloc(3);
+  PolyMonosFree(arr);
+  Mono *again = PolyMonosAlloc(3);
+  Mono *large = PolyMonosAlloc(100);
+  for (size_t i = 0; i < 1000; i++)
+    PolyMonosFree(PolyMonosAlloc(i % 16 + 1));
+  PolyAllocStats after = PolyAllocGetStats();
+#ifdef POLY_POOL
+  // Zwolniony blok wraca na początek listy wolnych bloków swojej klasy.
+  res &= again == arr;
+  res &= after.pool_allocs - before.pool_allocs == 1002;
+  res &= after.large_allocs - before.large_allocs == 1;
+  // Każda klasa potrzebuje co najwyżej jednego nowego fragmentu pamięci.
+  res &= after.pool_slabs - before.pool_slabs <= 8;
+  res &= after.pool_refills >= after.pool_slabs;
+#else
+  (void)arr;
+  res &= before.pool_allocs == 0 && after.pool_allocs == 0 &&
+         after.pool_slabs == 0 && after.large_allocs == 0;
+#endif
+  PolyMonosFree(large);
+  PolyMonosFree(again);
+  return res;
+}
+
+/**
+ * To jest struktura przechowująca liczniki alokatora zliczającego przydziały.
+ */
+typedef struct AllocCounter {
+  size_t mallocs; ///< liczba przydziałów
+  size_t reallocs; ///< liczba zmian rozmiaru
+  size_t frees; ///< liczba zwolnień
+} AllocCounter;
+
+/** Przydziela pamięć i zlicza przydział. */
+static void *CountingMalloc(void *context, size_t size) {
+  ((AllocCounter *)context)->mallocs++;
+  return malloc(size);
+}
+
+/** Zmienia rozmiar pamięci i zlicza zmianę. */
+static void *CountingRealloc(void *context, void *ptr, size_t size) {
+  ((AllocCounter *)context)->reallocs++;
+  return realloc(ptr, size);
+}
+
+/** Zwalnia pamięć i zlicza zwolnienie. */
+static void CountingFree(void *context, void *ptr) {
+  if (ptr != NULL)
+    ((AllocCounter *)context)->frees++;
+  free(ptr);
+}
+
+/**
+ * Sprawdza, czy pamięć wielomianów pochodzi z alokatora ustawionego przez
+ * PolySetAllocator i czy po usunięciu wszystkich wielomianów każdy przydział
+ * ma swoje zwolnienie. Z pulą alokator można ustawić tylko przed pierwszym
+ * przydziałem, więc wtedy sprawdzane jest tylko jego ustawianie.
+ */
+static bool AllocatorTest(void) {
+  bool res = true;
+  AllocCounter counter = {0, 0, 0};
+  PolyAllocator counting = {.malloc_fn = CountingMalloc,
+                            .realloc_fn = CountingRealloc,
+                            .free_fn = CountingFree, .context = &counter};
+  PolySetAllocator(&counting);
+  PolyAllocator current = PolyGetAllocator();
+  res &= current.malloc_fn == CountingMalloc && current.context == &counter;
+
+#ifndef POLY_POOL
+  Poly p = RandomPoly(3, 5, 10, 20), q = RandomPoly(2, 5, 10, 20);
+  Poly sum = PolyAdd(&p, &q);
+  Poly prod = PolyMul(&p, &q);
+  Poly args[] = {PolyClone(&q), C(3), P(C(1), 2)};
+  Poly composed = PolyCompose(&prod, SIZE(args), args);
+  Poly contiguous = PolyCloneContiguous(&composed);
+  Poly sub = PolyClone(&(contiguous.arr[0].p));
+  PolyDestroy(&contiguous);
+  sum = PolyAddOwn(&sum, &sub);
+  for (size_t i = 0; i < SIZE(args); i++)
+    PolyDestroy(&(args[i]));
+  PolyDestroy(&composed);
+  PolyDestroy(&prod);
+  PolyDestroy(&sum);
+  PolyDestroy(&q);
+  PolyDestroy(&p);
+  res &= counter.mallocs > 0 && counter.mallocs == counter.frees;
+#endif
+
+  PolySetAllocator(NULL);
+  current = PolyGetAllocator();
+  res &= current.malloc_fn != CountingMalloc && current.context == NULL;
+  return res;
+}
+
+/**
+ * Sprawdza, czy kopia z PolyClone współdzieląca tablice z oryginałem nie
+ * zmienia się, gdy oryginał jest przekazywany na własność operacjom, które
+ * mogą modyfikować jego tablice w miejscu, i czy kopię i oryginał można
+ * usuwać w dowolnej kolejności.
+ */
+static bool CloneShareTest(void) {
+  bool res = true;
+  for (int t = 0; t < 50; t++) {
+    Poly p = RandomPoly(3, 4, 8, 20), q = RandomPoly(3, 4, 8, 20);
+    Poly expected[] = {PolyAdd(&p, &q), PolySub(&p, &q), PolyMul(&p, &q),
+                       PolyNeg(&p)};
+    for (size_t i = 0; i < SIZE(expected); i++) {
+      Poly original = DeepCopy(&p), other = DeepCopy(&q);
+      Poly clone = PolyClone(&original), other_clone = PolyClone(&other);
+      Poly result;
+      switch (i) {
+        case 0:
+          result = PolyAddOwn(&original, &other);
+          break;
+        case 1:
+          result = PolySubOwn(&original, &other);
+          break;
+        case 2:
+          result = PolyMulOwn(&original, &other);
+          break;
+        default:
+          PolyDestroy(&other);
+          result = PolyNegOwn(&original);
+      }
+      res &= PolyIsEq(&result, &(expected[i]));
+      res &= PolyIsEq(&clone, &p) && PolyIsEq(&other_clone, &q);
+      PolyDestroy(&result);
+      PolyDestroy(&other_clone);
+      PolyDestroy(&clone);
+    }
+    for (size_t i = 0; i < SIZE(expected); i++)
+      PolyDestroy(&(expected[i]));
+
+    // Oryginał usuwany przed kopią.
+    Poly original = DeepCopy(&p);
+    Poly clone = PolyClone(&original);
+    PolyDestroy(&original);
+    res &= PolyIsEq(&clone, &p);
+    PolyDestroy(&clone);
+
+    // Kopia usuwana przed oryginałem.
+    original = DeepCopy(&p);
+    clone = PolyClone(&original);
+    PolyDestroy(&clone);
+    res &= PolyIsEq(&original, &p);
+    PolyDestroy(&original);
+
+    PolyDestroy(&q);
+    PolyDestroy(&p);
+  }
+  return res;
+}
+
+/**
+ * Sprawdza tablicę unikatową: równe wielomiany utworzone niezależnie mają
+ * wspólne tablice jednomianów, a usunięcie ostatniego odwołania usuwa
+ * tablicę z tablicy unikatowej. Tablice z obszaru nie trafiają do niej.
+ * Bez POLY_HASH_CONS tablica unikatowa jest pusta.
+ */
+static bool InternTest(void) {
+  bool res = true;
+  size_t count = PolyInternCount();
+  Poly p = P(P(C(1), 1, C(2), 2), 1, C(3), 2);
+  Poly q = P(P(C(1), 1, C(2), 2), 1, C(3), 2);
+#ifdef POLY_HASH_CONS
+  // Nowe są dwa poziomy: wielomian i współczynnik jego pierwszego jednomianu.
+  res &= PolyInternCount() == count + 2;
+  res &= p.arr == q.arr && PolyIsInterned(&p);
+  res &= p.arr[0].p.arr == q.arr[0].p.arr;
+  PolyDestroy(&p);
+  res &= PolyInternCount() == count + 2 && PolyIsEq(&q, &q);
+  PolyDestroy(&q);
+  res &= PolyInternCount() == count;
+
+  for (int t = 0; t < 50; t++) {
+    Poly r = RandomPoly(3, 4, 8, 20);
+    size_t r_count = PolyInternCount();
+    Poly copy = DeepCopy(&r);
+    res &= PolyInternCount() == r_count;
+    if (!PolyIsCoeff(&r) && !PolyIsInline(&r))
+      res &= r.arr == copy.arr && PolyIsInterned(&r);
+    PolyDestroy(&copy);
+    PolyDestroy(&r);
+  }
+  res &= PolyInternCount() == count;
+
+  PolyArena arena;
+  PolyArenaBegin(&arena, false);
+  Poly in_arena = P(P(C(5), 1, C(6), 2), 1, C(7), 2);
+  res &= !PolyIsInterned(&in_arena) && PolyInternCount() == count;
+  Poly exported = PolyArenaEnd(&arena, &in_arena);
+  res &= PolyIsInterned(&exported) && PolyInternCount() == count + 2;
+  PolyDestroy(&exported);
+  res &= PolyInternCount() == count;
+#else
+  res &= count == 0 && !PolyIsInterned(&p) && p.arr != q.arr;
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+#endif
+  return res;
+}
+
+/**
+ * Sprawdza operacje na jednomianach @f$cx_i^e@f$ przechowywanych bez tablicy
+ * jednomianów: porównywanie, kopiowanie, wartość w punkcie i dodawanie
+ * przejmujące argumenty na własność, również gdy taki jednomian jest
+ * współczynnikiem w wielomianie z tablicą.
+ */
+static bool InlineTest(void) {
+  bool res = true;
+  Poly a = P(C(3), 2);
+  res &= PolyIsInline(&a) && PolySize(&a) == 1;
+
+  Poly equal = P(C(3), 2);
+  Poly different[] = {P(C(3), 3), P(C(4), 2), C(3), P(C(3), 2, C(1), 3),
+                      P(P(C(3), 2), 2)};
+  res &= PolyIsEq(&a, &equal) && PolyIsEq(&equal, &a);
+  for (size_t i = 0; i < SIZE(different); i++) {
+    res &= !PolyIsEq(&a, &(different[i])) && !PolyIsEq(&(different[i]), &a);
+    PolyDestroy(&(different[i]));
+  }
+  PolyDestroy(&equal);
+
+  Poly nested = P(C(1), 0, P(C(3), 2), 1);
+  Poly nested_copy = DeepCopy(&nested);
+  res &= PolyIsInline(&(nested.arr[1].p));
+  res &= PolyIsEq(&nested, &nested_copy);
+
+  Poly clone = PolyClone(&a);
+  res &= PolyIsInline(&clone) && PolyIsEq(&clone, &a);
+  PolyDestroy(&clone);
+
+  Poly at = PolyAt(&a, 2);
+  res &= PolyIsCoeff(&at) && at.coeff == 12;
+  at = PolyAt(&nested, 2);
+  Poly at_expected = P(C(1), 0, C(6), 2);
+  res &= PolyIsEq(&at, &at_expected);
+  PolyDestroy(&at);
+  PolyDestroy(&at_expected);
+  Poly outer = P(P(C(3), 2), 1);
+  at = PolyAt(&outer, 2);
+  res &= PolyIsInline(&at) && at.coeff == 6 && PolyInlineExp(&at) == 2;
+  PolyDestroy(&at);
+  PolyDestroy(&outer);
+
+  struct {
+    Poly p, q, expected;
+  } sums[] = {
+    {P(C(3), 2), P(C(-3), 2), C(0)},
+    {P(C(3), 2), P(C(1), 2), P(C(4), 2)},
+    {P(C(3), 2), P(C(1), 5), P(C(3), 2, C(1), 5)},
+    {P(C(3), 2), C(1), P(C(1), 0, C(3), 2)},
+    {P(C(3), 2, C(1), 5), P(C(-1), 5), P(C(3), 2)},
+    {P(C(1), 0, P(C(3), 2), 1), P(P(C(-3), 2), 1), C(1)},
+    {P(C(1), 0, P(C(3), 2), 1), P(P(C(1), 2), 1), P(C(1), 0, P(C(4), 2), 1)},
+  };
+  for (size_t i = 0; i < SIZE(sums); i++) {
+    Poly sum = PolyAddOwn(&(sums[i].p), &(sums[i].q));
+    res &= PolyIsEq(&sum, &(sums[i].expected));
+    res &= PolyIsInline(&sum) == PolyIsInline(&(sums[i].expected));
+    PolyDestroy(&sum);
+    PolyDestroy(&(sums[i].expected));
+  }
+
+  PolyDestroy(&nested_copy);
+  PolyDestroy(&nested);
+  PolyDestroy(&a);
+  return res;
+}
+
+/**
+ * Sprawdza kopie z PolyCloneContiguous: są równe oryginałowi, są zwalniane
+ * jednym zwolnieniem pamięci, a ich poziomy skopiowane przez PolyClone
+ * przeżywają usunięcie korzenia kopii i mogą być przekazywane operacjom
+ * przejmującym je na własność bez zmiany innych kopii.
+ */
+static bool ContiguousTest(void) {
+  bool res = true;
+  Poly fixed[] = {C(0), C(5), P(C(3), 2), P(C(1), 0, P(C(3), 2), 1)};
+  for (size_t i = 0; i < SIZE(fixed); i++) {
+    Poly copy = PolyCloneContiguous(&(fixed[i]));
+    res &= PolyIsEq(&copy, &(fixed[i]));
+    PolyDestroy(&copy);
+    PolyDestroy(&(fixed[i]));
+  }
+
+  for (int t = 0; t < 50; t++) {
+    Poly p = RandomPoly(3, 4, 8, 20), q = RandomPoly(2, 4, 8, 20);
+    Poly copy = PolyCloneContiguous(&p);
+    res &= PolyIsEq(&copy, &p) && PolyIsEq(&p, &copy);
+    if (PolyIsCoeff(&copy) || PolyIsInline(&copy)) {
+      PolyDestroy(&copy);
+      PolyDestroy(&q);
+      PolyDestroy(&p);
+      continue;
+    }
+
+    // Poziomy wyjęte z kopii przed usunięciem jej korzenia.
+    Poly first = PolyClone(&(copy.arr[0].p));
+    Poly last = PolyClone(&(copy.arr[copy.size - 1].p));
+    Poly whole = PolyClone(&copy);
+    PolyDestroy(&copy);
+    res &= PolyIsEq(&whole, &p);
+    PolyDestroy(&whole);
+    res &= PolyIsEq(&first, &(p.arr[0].p));
+
+    Poly expected = PolyAdd(&(p.arr[p.size - 1].p), &q);
+    Poly sum = PolyAddOwn(&last, &q);
+    res &= PolyIsEq(&sum, &expected);
+    res &= PolyIsEq(&first, &(p.arr[0].p));
+    PolyDestroy(&sum);
+    PolyDestroy(&expected);
+    PolyDestroy(&first);
+    PolyDestroy(&p);
+  }
+
+#ifndef POLY_POOL
+  // Cały blok kopii jest jednym przydziałem alokatora.
+  Poly p = P(P(C(1), 1, C(2), 2), 1, P(C(3), 1, P(C(4), 1, C(5), 2), 3), 2);
+  AllocCounter counter = {0, 0, 0};
+  PolyAllocator counting = {.malloc_fn = CountingMalloc,
+                            .realloc_fn = CountingRealloc,
+                            .free_fn = CountingFree, .context = &counter};
+  PolyAllocator previous = PolyGetAllocator();
+  PolySetAllocator(&counting);
+  Poly copy = PolyCloneContiguous(&p);
+  Poly sub = PolyClone(&(copy.arr[1].p));
+  res &= counter.mallocs == 1;
+  PolyDestroy(&copy);
+  PolyDestroy(&sub);
+  res &= counter.mallocs == counter.frees;
+  PolySetAllocator(&previous);
+  PolyDestroy(&p);
+#endif
+  return res;
+}
+
 /** GRUPY TESTÓW **/
 
 static bool SimpleNegGroup(void) {
@@ -4003,9 +5400,6 @@ static bool MemoryGroup(void) {
 #define TEST_FAIL  125
 #define TEST_WRONG 2
 
-// Liczba elementów tablicy x
-#define SIZE(x) (sizeof (x) / sizeof (x)[0])
-
 typedef struct {
   char const *name;
   bool (*function)(void);
@@ -4047,6 +5441,27 @@ static const test_list_t test_list[] = {
         TEST(MemoryThiefTest),
         TEST(MemoryFreeTest),
         TEST(MemoryGroup),
+        TEST(KroneckerMulTest),
+        TEST(KaratsubaMulTest),
+        TEST(NttMulTest),
+        TEST(OwnOpsTest),
+        TEST(NegOwnTest),
+        TEST(SubNegTest),
+        TEST(PolyAtNaiveTest),
+        TEST(ComposeNaiveTest),
+        TEST(ComposeBatchTest),
+        TEST(EvalBatchTest),
+        TEST(ProgramEvalTest),
+        TEST(JitEvalTest),
+        TEST(DistTest),
+        TEST(ParallelMulTest),
+        TEST(ArenaTest),
+        TEST(PoolTest),
+        TEST(AllocatorTest),
+        TEST(CloneShareTest),
+        TEST(InternTest),
+        TEST(InlineTest),
+        TEST(ContiguousTest),
 };
 
 /** Funkcja main zmieniona tak, aby działała bez argumentów. **/
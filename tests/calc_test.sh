@@ -0,0 +1,29 @@
+#!/bin/sh
+# Uruchamia kalkulator na plikach NAZWA.in z podanego katalogu i porównuje
+# standardowe wyjście z plikiem NAZWA.out, a wyjście błędów z NAZWA.err.
+# Użycie: calc_test.sh <plik wykonywalny poly> <katalog z testami>
+
+if [ $# -ne 2 ] || [ ! -x "$1" ] || [ ! -d "$2" ]; then
+  echo "Usage: $0 <poly executable> <tests directory>" >&2
+  exit 2
+fi
+
+prog=$1
+dir=$2
+out=$(mktemp)
+err=$(mktemp)
+trap 'rm -f "$out" "$err"' EXIT
+
+failed=0
+for input in "$dir"/*.in; do
+  name=${input%.in}
+  "$prog" < "$input" > "$out" 2> "$err"
+  if cmp -s "$out" "$name.out" && cmp -s "$err" "$name.err"; then
+    echo "OK    $(basename "$name")"
+  else
+    echo "BŁĄD  $(basename "$name")"
+    failed=1
+  fi
+done
+
+exit $failed